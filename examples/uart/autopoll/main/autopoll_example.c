@@ -0,0 +1,58 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "esp_log.h"
+
+#include "pn532.h"
+
+#define UART_TX_PIN    CONFIG_UART_TX_GPIO_PIN
+#define UART_RX_PIN    CONFIG_UART_RX_GPIO_PIN
+#define UART_PORT      CONFIG_UART_PORT
+#define UART_BAUD_RATE CONFIG_UART_BAUD_RATE
+
+static const char* TAG = "example";
+
+void example_task(void* pvParameters) {
+    pn532_handle_t pn532 = (pn532_handle_t) pvParameters;
+
+    ESP_ERROR_CHECK(pn532_start(pn532));
+    ESP_ERROR_CHECK(pn532_SAM_configuration(pn532));
+
+    pn532_autopoll_config_t autopoll_config = {
+        .types = {PN532_AUTOPOLL_MIFARE, PN532_AUTOPOLL_ISO14443_4A},
+        .num_types = 2,
+        .poll_count = 0x10, // 16 polls per type before the command is reissued
+        .period = 0x01, // 150ms between polls
+        .dedup_ttl_ms = 1000, // report each card once when it arrives and once when it leaves
+    };
+    QueueHandle_t events = NULL;
+    ESP_ERROR_CHECK(pn532_autopoll_start(pn532, &autopoll_config, &events));
+
+    pn532_scan_event_t event;
+    while(xQueueReceive(events, &event, portMAX_DELAY) == pdTRUE) {
+        ESP_LOGI(TAG, "%s target type %02X, SAK %02X, UID: ", (event.kind == PN532_SCAN_DEPARTED) ? "departed" : "arrived", event.type, event.target.sak);
+        ESP_LOG_BUFFER_HEX_LEVEL(TAG, event.target.uid, event.target.uid_len, ESP_LOG_INFO);
+    }
+
+    ESP_LOGI(TAG, "ended example task");
+
+    pn532_free(pn532);
+    vTaskDelete(NULL);
+}
+
+void app_main() {
+    pn532_config_t pn532_config = {
+        .protocol = PN532_UART_PROTOCOL,
+        .uart = {
+            .tx = UART_TX_PIN,
+            .rx = UART_RX_PIN,
+            .uart_port = UART_PORT,
+            .baud_rate = UART_BAUD_RATE,
+        },
+    };
+    pn532_handle_t pn532 = NULL;
+    ESP_ERROR_CHECK(pn532_init(&pn532, &pn532_config));
+
+    xTaskCreate(example_task, "example", 4096, (void*) pn532, 5, NULL);
+}
@@ -0,0 +1,73 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "esp_log.h"
+
+#include "pn532.h"
+
+#define UART_BAUD_RATE CONFIG_UART_BAUD_RATE
+
+static const char* TAG = "example";
+
+void example_task(void* pvParameters) {
+    pn532_group_handle_t group = (pn532_group_handle_t) pvParameters;
+
+    QueueHandle_t events = NULL;
+    ESP_ERROR_CHECK(pn532_group_start(group, &events));
+
+    pn532_scan_event_t event;
+    while(xQueueReceive(events, &event, portMAX_DELAY) == pdTRUE) {
+        ESP_LOGI(TAG, "reader %d, target type %02X, SAK %02X, UID: ", event.reader, event.type, event.target.sak);
+        ESP_LOG_BUFFER_HEX_LEVEL(TAG, event.target.uid, event.target.uid_len, ESP_LOG_INFO);
+    }
+
+    ESP_LOGI(TAG, "ended example task");
+
+    pn532_group_free(group);
+    vTaskDelete(NULL);
+}
+
+void app_main() {
+    pn532_group_config_t group_config = {
+        .readers = {
+            {
+                .config = {
+                    .protocol = PN532_UART_PROTOCOL,
+                    .uart = {
+                        .tx = CONFIG_READER0_UART_TX_GPIO_PIN,
+                        .rx = CONFIG_READER0_UART_RX_GPIO_PIN,
+                        .uart_port = CONFIG_READER0_UART_PORT,
+                        .baud_rate = UART_BAUD_RATE,
+                    },
+                },
+                .task_core = 0,
+                .task_pinned = true,
+            },
+            {
+                .config = {
+                    .protocol = PN532_UART_PROTOCOL,
+                    .uart = {
+                        .tx = CONFIG_READER1_UART_TX_GPIO_PIN,
+                        .rx = CONFIG_READER1_UART_RX_GPIO_PIN,
+                        .uart_port = CONFIG_READER1_UART_PORT,
+                        .baud_rate = UART_BAUD_RATE,
+                    },
+                },
+                .task_core = 1,
+                .task_pinned = true,
+            },
+        },
+        .num_readers = 2,
+        .autopoll = {
+            .types = {PN532_AUTOPOLL_MIFARE, PN532_AUTOPOLL_ISO14443_4A},
+            .num_types = 2,
+            .poll_count = 0x10,
+            .period = 0x01,
+        },
+    };
+    pn532_group_handle_t group = NULL;
+    ESP_ERROR_CHECK(pn532_group_init(&group, &group_config));
+
+    xTaskCreate(example_task, "example", 4096, (void*) group, 5, NULL);
+}
@@ -0,0 +1,68 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+
+#include "pn532.h"
+
+#define UART_TX_PIN    CONFIG_UART_TX_GPIO_PIN
+#define UART_RX_PIN    CONFIG_UART_RX_GPIO_PIN
+#define UART_PORT      CONFIG_UART_PORT
+#define UART_BAUD_RATE CONFIG_UART_BAUD_RATE
+
+static const char* TAG = "example";
+
+void example_task(void* pvParameters) {
+    pn532_handle_t pn532 = (pn532_handle_t) pvParameters;
+
+    pn532_bring_up_config_t bring_up_config = {
+        .passive_activation_retries = 0x01,
+    };
+    pn532_bring_up_report_t report;
+    ESP_ERROR_CHECK(pn532_bring_up(pn532, &bring_up_config, &report));
+    ESP_LOGI(TAG, "wake %lu us, link %lu us, SAM %lu us, RF %lu us",
+             (unsigned long) report.wake_us, (unsigned long) report.link_us,
+             (unsigned long) report.sam_us, (unsigned long) report.rf_us);
+
+    pn532_lowpower_config_t lowpower_config = {
+        .sleep_ms = 500, // powered down between scans
+        .scan_retries = 0x01, // each scan gives up quickly when the field is empty
+    };
+
+    while(true) {
+        pn532_target_t target;
+        esp_err_t err = pn532_lowpower_scan(pn532, &lowpower_config, 10000, &target);
+        if(err == ESP_ERR_NOT_FOUND) {
+            continue;
+        }
+        ESP_ERROR_CHECK(err);
+
+        ESP_LOGI(TAG, "SAK %02X, UID: ", target.sak);
+        ESP_LOG_BUFFER_HEX_LEVEL(TAG, target.uid, target.uid_len, ESP_LOG_INFO);
+
+        pn532_lowpower_stats_t stats;
+        ESP_ERROR_CHECK(pn532_get_lowpower_stats(pn532, &stats));
+        ESP_LOGI(TAG, "wake to UID %lu us, %lu cycles, sleep %llu ms, wake %llu ms, scan %llu ms",
+                 (unsigned long) stats.last_wake_to_uid_us, (unsigned long) stats.cycles,
+                 (unsigned long long) (stats.sleep_us / 1000), (unsigned long long) (stats.wake_us / 1000), (unsigned long long) (stats.scan_us / 1000));
+
+        // card handled, let it leave the field
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
+
+void app_main() {
+    pn532_config_t pn532_config = {
+        .protocol = PN532_UART_PROTOCOL,
+        .uart = {
+            .tx = UART_TX_PIN,
+            .rx = UART_RX_PIN,
+            .uart_port = UART_PORT,
+            .baud_rate = UART_BAUD_RATE,
+        },
+    };
+    pn532_handle_t pn532 = NULL;
+    ESP_ERROR_CHECK(pn532_init(&pn532, &pn532_config));
+
+    xTaskCreate(example_task, "example", 4096, (void*) pn532, 5, NULL);
+}
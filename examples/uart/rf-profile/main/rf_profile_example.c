@@ -0,0 +1,103 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+
+#include "pn532.h"
+
+#define UART_TX_PIN    CONFIG_UART_TX_GPIO_PIN
+#define UART_RX_PIN    CONFIG_UART_RX_GPIO_PIN
+#define UART_PORT      CONFIG_UART_PORT
+#define UART_BAUD_RATE CONFIG_UART_BAUD_RATE
+
+#define POLL_CYCLES 50
+
+static const char* TAG = "example";
+
+typedef struct {
+    const char* name;
+    pn532_rf_profile_t profile;
+} preset_t;
+
+// the default profile retries forever, so it never returns on an empty field
+static const preset_t presets[] = {
+    {"fast poll", PN532_RF_PROFILE_FAST_POLL()},
+    {"long range", PN532_RF_PROFILE_LONG_RANGE()},
+    {"low power", PN532_RF_PROFILE_LOW_POWER()},
+};
+
+// times InListPassiveTarget on an empty field, one cycle is command written to response received
+static void benchmark(pn532_handle_t pn532, const preset_t* preset) {
+    ESP_ERROR_CHECK(pn532_set_rf_profile(pn532, &preset->profile));
+
+    uint8_t command[] = {
+        PN532_COMMAND_INLISTPASSIVETARGET,
+        0x01, // max targets
+        PN532_MIFARE_ISO14443A,
+    };
+
+    uint32_t min_us = UINT32_MAX;
+    uint32_t max_us = 0;
+    uint64_t total_us = 0;
+    size_t cycles = 0;
+    for(size_t i = 0; i < POLL_CYCLES; i++) {
+        pn532_latency_t latency;
+        esp_err_t err = pn532_send_command_timed(pn532, command, sizeof(command), 30, 1000, &latency);
+        if(err != ESP_OK) {
+            ESP_LOGW(TAG, "%s: poll failed: %s", preset->name, esp_err_to_name(err));
+            continue;
+        }
+
+        uint32_t cycle_us = latency.ack_latency_us + latency.response_latency_us;
+        min_us = (cycle_us < min_us) ? cycle_us : min_us;
+        max_us = (cycle_us > max_us) ? cycle_us : max_us;
+        total_us += cycle_us;
+        cycles++;
+    }
+
+    if(!cycles) {
+        ESP_LOGE(TAG, "%s: no poll completed", preset->name);
+        return;
+    }
+
+    ESP_LOGI(TAG, "%-10s poll cycle avg %lu us, min %lu us, max %lu us (%d cycles)", preset->name,
+             (unsigned long) (total_us / cycles), (unsigned long) min_us, (unsigned long) max_us, (int) cycles);
+}
+
+void example_task(void* pvParameters) {
+    pn532_handle_t pn532 = (pn532_handle_t) pvParameters;
+
+    pn532_bring_up_config_t bring_up_config = {
+        .passive_activation_retries = 0x00,
+    };
+    ESP_ERROR_CHECK(pn532_bring_up(pn532, &bring_up_config, NULL));
+
+    ESP_LOGI(TAG, "keep the field empty, %d polls per preset", POLL_CYCLES);
+    for(size_t i = 0; i < sizeof(presets) / sizeof(presets[0]); i++) {
+        benchmark(pn532, &presets[i]);
+    }
+
+    pn532_rf_profile_t profile = PN532_RF_PROFILE_DEFAULT();
+    ESP_ERROR_CHECK(pn532_set_rf_profile(pn532, &profile));
+
+    ESP_LOGI(TAG, "ended example task");
+
+    pn532_free(pn532);
+    vTaskDelete(NULL);
+}
+
+void app_main() {
+    pn532_config_t pn532_config = {
+        .protocol = PN532_UART_PROTOCOL,
+        .uart = {
+            .tx = UART_TX_PIN,
+            .rx = UART_RX_PIN,
+            .uart_port = UART_PORT,
+            .baud_rate = UART_BAUD_RATE,
+        },
+    };
+    pn532_handle_t pn532 = NULL;
+    ESP_ERROR_CHECK(pn532_init(&pn532, &pn532_config));
+
+    xTaskCreate(example_task, "example", 4096, (void*) pn532, 5, NULL);
+}
@@ -0,0 +1,295 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct fake_task {
+    pthread_t thread;
+    TaskFunction_t function;
+    void* arg;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify[configTASK_NOTIFICATION_ARRAY_ENTRIES];
+};
+
+struct fake_semaphore {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned count;
+    bool is_static;
+};
+
+_Static_assert(sizeof(struct fake_semaphore) <= sizeof(StaticSemaphore_t), "StaticSemaphore_t too small");
+
+struct fake_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    size_t length;
+    size_t item_size;
+    size_t head;
+    size_t count;
+    uint8_t* items;
+};
+
+static __thread struct fake_task* current_task;
+
+static void cond_init(pthread_cond_t* cond) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static struct timespec deadline_after(TickType_t ticks) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += ticks / 1000;
+    ts.tv_nsec += (long) (ticks % 1000) * 1000000L;
+    if(ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+// waits on cond until woken or the deadline passed, returns false on timeout
+static bool cond_wait(pthread_cond_t* cond, pthread_mutex_t* lock, TickType_t ticks, const struct timespec* deadline) {
+    if(ticks == portMAX_DELAY) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (TickType_t) ((uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static struct fake_task* task_new(TaskFunction_t function, void* arg) {
+    struct fake_task* task = calloc(1, sizeof(struct fake_task));
+    if(!task) {
+        return NULL;
+    }
+    task->function = function;
+    task->arg = arg;
+    pthread_mutex_init(&task->lock, NULL);
+    cond_init(&task->cond);
+    return task;
+}
+
+static void* task_entry(void* arg) {
+    struct fake_task* task = (struct fake_task*) arg;
+    current_task = task;
+    task->function(task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stack_size, void* arg, UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    struct fake_task* task = task_new(function, arg);
+    if(!task) {
+        return pdFAIL;
+    }
+    if(handle) {
+        *handle = task;
+    }
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int rc = pthread_create(&task->thread, &attr, task_entry, task);
+    pthread_attr_destroy(&attr);
+    return rc == 0 ? pdPASS : pdFAIL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_size, void* arg, UBaseType_t priority, TaskHandle_t* handle) {
+    return xTaskCreatePinnedToCore(function, name, stack_size, arg, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    // only self deletion is used, the task object stays valid for late notifications
+    if(!task || task == current_task) {
+        pthread_exit(NULL);
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    struct timespec ts = {
+        .tv_sec = ticks / 1000,
+        .tv_nsec = (long) (ticks % 1000) * 1000000L,
+    };
+    while(nanosleep(&ts, &ts) == -1 && errno == EINTR) {
+    }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    // threads not created through the fake (main) get a task object on first use
+    if(!current_task) {
+        current_task = task_new(NULL, NULL);
+    }
+    return current_task;
+}
+
+uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear, TickType_t ticks) {
+    struct fake_task* task = xTaskGetCurrentTaskHandle();
+    struct timespec deadline = deadline_after(ticks);
+
+    pthread_mutex_lock(&task->lock);
+    while(!task->notify[index] && ticks && cond_wait(&task->cond, &task->lock, ticks, &deadline)) {
+    }
+    uint32_t value = task->notify[index];
+    if(value) {
+        task->notify[index] = clear ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+BaseType_t xTaskNotifyGiveIndexed(TaskHandle_t task, UBaseType_t index) {
+    pthread_mutex_lock(&task->lock);
+    task->notify[index]++;
+    pthread_cond_broadcast(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveIndexedFromISR(TaskHandle_t task, UBaseType_t index, BaseType_t* woken) {
+    (void) xTaskNotifyGiveIndexed(task, index);
+    if(woken) {
+        *woken = pdFALSE;
+    }
+}
+
+static SemaphoreHandle_t semaphore_init(struct fake_semaphore* semaphore, unsigned count, bool is_static) {
+    memset(semaphore, 0, sizeof(struct fake_semaphore));
+    pthread_mutex_init(&semaphore->lock, NULL);
+    cond_init(&semaphore->cond);
+    semaphore->count = count;
+    semaphore->is_static = is_static;
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    struct fake_semaphore* semaphore = malloc(sizeof(struct fake_semaphore));
+    return semaphore ? semaphore_init(semaphore, 1, false) : NULL;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t* buffer) {
+    return semaphore_init((struct fake_semaphore*) buffer, 1, true);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    struct fake_semaphore* semaphore = malloc(sizeof(struct fake_semaphore));
+    return semaphore ? semaphore_init(semaphore, 0, false) : NULL;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t* buffer) {
+    return semaphore_init((struct fake_semaphore*) buffer, 0, true);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    struct timespec deadline = deadline_after(ticks);
+
+    pthread_mutex_lock(&semaphore->lock);
+    while(!semaphore->count && ticks && cond_wait(&semaphore->cond, &semaphore->lock, ticks, &deadline)) {
+    }
+    BaseType_t taken = semaphore->count ? pdTRUE : pdFALSE;
+    if(taken) {
+        semaphore->count--;
+    }
+    pthread_mutex_unlock(&semaphore->lock);
+    return taken;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    pthread_mutex_lock(&semaphore->lock);
+    BaseType_t given = semaphore->count ? pdFALSE : pdTRUE; // binary and mutex only
+    semaphore->count = 1;
+    pthread_cond_broadcast(&semaphore->cond);
+    pthread_mutex_unlock(&semaphore->lock);
+    return given;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    pthread_cond_destroy(&semaphore->cond);
+    pthread_mutex_destroy(&semaphore->lock);
+    if(!semaphore->is_static) {
+        free(semaphore);
+    }
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    struct fake_queue* queue = calloc(1, sizeof(struct fake_queue));
+    if(!queue) {
+        return NULL;
+    }
+    queue->items = malloc(length * item_size);
+    if(!queue->items) {
+        free(queue);
+        return NULL;
+    }
+    queue->length = length;
+    queue->item_size = item_size;
+    pthread_mutex_init(&queue->lock, NULL);
+    cond_init(&queue->changed);
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    struct timespec deadline = deadline_after(ticks);
+
+    pthread_mutex_lock(&queue->lock);
+    while(queue->count == queue->length && ticks && cond_wait(&queue->changed, &queue->lock, ticks, &deadline)) {
+    }
+    BaseType_t sent = pdFALSE;
+    if(queue->count < queue->length) {
+        size_t tail = (queue->head + queue->count) % queue->length;
+        memcpy(queue->items + tail * queue->item_size, item, queue->item_size);
+        queue->count++;
+        sent = pdTRUE;
+        pthread_cond_broadcast(&queue->changed);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return sent;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+    struct timespec deadline = deadline_after(ticks);
+
+    pthread_mutex_lock(&queue->lock);
+    while(!queue->count && ticks && cond_wait(&queue->changed, &queue->lock, ticks, &deadline)) {
+    }
+    BaseType_t received = pdFALSE;
+    if(queue->count) {
+        memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        received = pdTRUE;
+        pthread_cond_broadcast(&queue->changed);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return received;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    pthread_cond_destroy(&queue->changed);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue->items);
+    free(queue);
+}
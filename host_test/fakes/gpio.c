@@ -0,0 +1,78 @@
+#include "driver/gpio.h"
+#include "fake_hw.h"
+
+#include <pthread.h>
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static int levels[GPIO_NUM_MAX];
+static gpio_isr_t handlers[GPIO_NUM_MAX];
+static void* handler_args[GPIO_NUM_MAX];
+static int initialized;
+
+static void gpio_init_levels(void) {
+    // idle high, like the pulled up IRQ line
+    if(!initialized) {
+        for(int i = 0; i < GPIO_NUM_MAX; i++) {
+            levels[i] = 1;
+        }
+        initialized = 1;
+    }
+}
+
+esp_err_t gpio_config(const gpio_config_t* config) {
+    return config->pin_bit_mask ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_install_isr_service(int flags) {
+    static int installed;
+    pthread_mutex_lock(&lock);
+    esp_err_t err = installed ? ESP_ERR_INVALID_STATE : ESP_OK;
+    installed = 1;
+    pthread_mutex_unlock(&lock);
+    return err;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t handler, void* arg) {
+    if(!GPIO_IS_VALID_GPIO(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&lock);
+    handlers[pin] = handler;
+    handler_args[pin] = arg;
+    pthread_mutex_unlock(&lock);
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t pin) {
+    pthread_mutex_lock(&lock);
+    handlers[pin] = NULL;
+    handler_args[pin] = NULL;
+    pthread_mutex_unlock(&lock);
+    return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t pin) {
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t pin) {
+    pthread_mutex_lock(&lock);
+    gpio_init_levels();
+    int level = levels[pin];
+    pthread_mutex_unlock(&lock);
+    return level;
+}
+
+void fake_gpio_set_level(int pin, int level) {
+    pthread_mutex_lock(&lock);
+    gpio_init_levels();
+    int falling = levels[pin] && !level;
+    levels[pin] = level;
+    gpio_isr_t handler = handlers[pin];
+    void* arg = handler_args[pin];
+    pthread_mutex_unlock(&lock);
+
+    if(falling && handler) {
+        handler(arg);
+    }
+}
@@ -0,0 +1,93 @@
+#include "driver/i2c_master.h"
+#include "fake_hw.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct fake_i2c_bus {
+    int port;
+};
+
+struct fake_i2c_dev {
+    uint16_t address;
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static fake_i2c_device_t device;
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t* config, i2c_master_bus_handle_t* bus) {
+    *bus = calloc(1, sizeof(struct fake_i2c_bus));
+    return *bus ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t i2c_del_master_bus(i2c_master_bus_handle_t bus) {
+    free(bus);
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus, const i2c_device_config_t* config, i2c_master_dev_handle_t* dev) {
+    *dev = calloc(1, sizeof(struct fake_i2c_dev));
+    if(!*dev) {
+        return ESP_ERR_NO_MEM;
+    }
+    (*dev)->address = config->device_address;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t dev) {
+    free(dev);
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t dev, const uint8_t* data, size_t len, int timeout_ms) {
+    pthread_mutex_lock(&lock);
+    if(device.write) {
+        device.write(device.arg, data, len);
+    }
+    pthread_mutex_unlock(&lock);
+    return device.write ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t i2c_master_multi_buffer_transmit(i2c_master_dev_handle_t dev, i2c_master_transmit_multi_buffer_info_t* buffers, size_t count, int timeout_ms) {
+    // one transaction on the bus, so the device sees the joined parts
+    size_t len = 0;
+    for(size_t i = 0; i < count; i++) {
+        len += buffers[i].buffer_size;
+    }
+    uint8_t* joined = malloc(len ? len : 1);
+    if(!joined) {
+        return ESP_ERR_NO_MEM;
+    }
+    size_t offset = 0;
+    for(size_t i = 0; i < count; i++) {
+        memcpy(joined + offset, buffers[i].write_buffer, buffers[i].buffer_size);
+        offset += buffers[i].buffer_size;
+    }
+    esp_err_t err = i2c_master_transmit(dev, joined, len, timeout_ms);
+    free(joined);
+    return err;
+}
+
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t dev, uint8_t* data, size_t len, int timeout_ms) {
+    pthread_mutex_lock(&lock);
+    if(device.read) {
+        device.read(device.arg, data, len);
+    }
+    pthread_mutex_unlock(&lock);
+    return device.read ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t i2c_master_probe(i2c_master_bus_handle_t bus, uint16_t address, int timeout_ms) {
+    return device.read ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+void fake_i2c_attach(const fake_i2c_device_t* attached) {
+    pthread_mutex_lock(&lock);
+    if(attached) {
+        device = *attached;
+    } else {
+        memset(&device, 0, sizeof(device));
+    }
+    pthread_mutex_unlock(&lock);
+}
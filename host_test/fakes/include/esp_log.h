@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdio.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+// messages above this level are dropped, tests raise it to debug a failure
+extern esp_log_level_t fake_log_level;
+
+#define FAKE_LOG(level, letter, tag, fmt, ...) do { \
+    if(fake_log_level >= (level)) { \
+        fprintf(stderr, letter " (%s) " fmt "\n", tag, ##__VA_ARGS__); \
+    } \
+} while(0)
+
+#define ESP_LOGE(tag, fmt, ...) FAKE_LOG(ESP_LOG_ERROR, "E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) FAKE_LOG(ESP_LOG_WARN, "W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) FAKE_LOG(ESP_LOG_INFO, "I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) FAKE_LOG(ESP_LOG_DEBUG, "D", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOG_BUFFER_HEX_LEVEL(tag, buffer, len, level) do { (void) (tag); (void) (buffer); (void) (len); (void) (level); } while(0)
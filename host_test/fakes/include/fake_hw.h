@@ -0,0 +1,33 @@
+#pragma once
+
+// test side hooks of the fake drivers, nothing in src/ includes this
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_log.h"
+
+// drives an input pin, a falling edge runs the handler added for it (the "ISR")
+void fake_gpio_set_level(int pin, int level);
+
+// everything the host writes to the port is passed to tx, bytes for the host go in with fake_uart_inject
+typedef void (*fake_uart_tx_t)(void* arg, const uint8_t* data, size_t len);
+void fake_uart_attach(int port, fake_uart_tx_t tx, void* arg);
+void fake_uart_inject(int port, const uint8_t* data, size_t len);
+
+// the device behind every i2c handle: write gets each transaction, read fills the whole transaction
+typedef struct {
+    void (*write)(void* arg, const uint8_t* data, size_t len);
+    void (*read)(void* arg, uint8_t* data, size_t len);
+    void* arg;
+} fake_i2c_device_t;
+void fake_i2c_attach(const fake_i2c_device_t* device);
+
+// the device behind every spi handle: write gets each transaction sent, read fills each transaction received,
+// cmd is the DW / SR / DR prefix
+typedef struct {
+    void (*write)(void* arg, uint8_t cmd, const uint8_t* data, size_t len);
+    void (*read)(void* arg, uint8_t cmd, uint8_t* data, size_t len);
+    void* arg;
+} fake_spi_device_t;
+void fake_spi_attach(const fake_spi_device_t* device);
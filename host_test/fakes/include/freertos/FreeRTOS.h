@@ -0,0 +1,33 @@
+#pragma once
+
+// FreeRTOS on top of pthreads, one tick per millisecond
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY ((TickType_t) 0xFFFFFFFFUL)
+#define portTICK_PERIOD_MS 1
+#define configTICK_RATE_HZ 1000
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES
+#define pdMS_TO_TICKS(ms) ((TickType_t) (ms))
+#define pdTICKS_TO_MS(ticks) ((uint32_t) (ticks))
+#define portYIELD_FROM_ISR(woken) (void) (woken)
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define IRAM_ATTR
+
+// large enough for the fake semaphore, static objects live inside it
+typedef struct {
+    uint8_t storage[256];
+} __attribute__((aligned(16))) StaticSemaphore_t;
+
+TickType_t xTaskGetTickCount(void);
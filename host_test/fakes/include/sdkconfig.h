@@ -0,0 +1,12 @@
+#pragma once
+
+// component defaults from Kconfig
+#define CONFIG_LOG_DEFAULT_LEVEL 3
+#define CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES 2
+#define CONFIG_PN532_BUFFER_SIZE 256
+#define CONFIG_PN532_UART_RX_BUFFER_SIZE 512
+#define CONFIG_PN532_UART_TX_BUFFER_SIZE 256
+#define CONFIG_PN532_STATS 1
+#define CONFIG_PN532_STATS_MAX_COMMANDS 12
+#define CONFIG_PN532_NACK_RETRIES 3
+#define CONFIG_PN532_UID_CACHE_SIZE 16
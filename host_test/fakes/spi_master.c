@@ -0,0 +1,108 @@
+#include "driver/spi_master.h"
+#include "fake_hw.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FAKE_SPI_HOSTS 4
+#define FAKE_SPI_DEFAULT_MAX_TRANSFER 4092 // what the real driver picks for max_transfer_sz 0 with DMA
+
+struct fake_spi_dev {
+    spi_host_device_t host;
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static fake_spi_device_t device;
+static struct {
+    bool initialized;
+    int max_transfer_sz;
+} buses[FAKE_SPI_HOSTS];
+
+void fake_spi_attach(const fake_spi_device_t* attached) {
+    pthread_mutex_lock(&lock);
+    if(attached) {
+        device = *attached;
+    } else {
+        memset(&device, 0, sizeof(device));
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t* config, spi_dma_chan_t dma) {
+    if(host < 0 || host >= FAKE_SPI_HOSTS || buses[host].initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    buses[host].initialized = true;
+    buses[host].max_transfer_sz = config->max_transfer_sz ? config->max_transfer_sz : FAKE_SPI_DEFAULT_MAX_TRANSFER;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host) {
+    if(host < 0 || host >= FAKE_SPI_HOSTS || !buses[host].initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    buses[host].initialized = false;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t* config, spi_device_handle_t* dev) {
+    if(host < 0 || host >= FAKE_SPI_HOSTS || !buses[host].initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *dev = calloc(1, sizeof(struct fake_spi_dev));
+    if(!*dev) {
+        return ESP_ERR_NO_MEM;
+    }
+    (*dev)->host = host;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t dev) {
+    free(dev);
+    return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t dev, spi_transaction_t* transaction) {
+    // same limit as the real driver: no transaction longer than the bus max_transfer_sz
+    size_t max_bits = (size_t) buses[dev->host].max_transfer_sz * 8;
+    if(transaction->length > max_bits || transaction->rxlength > max_bits) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&lock);
+    uint8_t cmd = (uint8_t) transaction->cmd;
+    size_t len = transaction->length / 8;
+    if(transaction->flags & SPI_TRANS_USE_TXDATA) {
+        if(device.write) {
+            device.write(device.arg, cmd, transaction->tx_data, len);
+        }
+    } else if(transaction->tx_buffer) {
+        if(device.write) {
+            device.write(device.arg, cmd, transaction->tx_buffer, len);
+        }
+    }
+
+    size_t rx_len = (transaction->rxlength ? transaction->rxlength : transaction->length) / 8;
+    uint8_t* rx = NULL;
+    if(transaction->flags & SPI_TRANS_USE_RXDATA) {
+        rx = transaction->rx_data;
+    } else if(transaction->rx_buffer) {
+        rx = transaction->rx_buffer;
+    }
+    if(rx) {
+        memset(rx, 0, rx_len);
+        if(device.read) {
+            device.read(device.arg, cmd, rx, rx_len);
+        }
+    }
+    pthread_mutex_unlock(&lock);
+    return ESP_OK;
+}
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t dev, TickType_t wait) {
+    return ESP_OK;
+}
+
+void spi_device_release_bus(spi_device_handle_t dev) {
+}
@@ -0,0 +1,166 @@
+#include "driver/uart.h"
+#include "fake_hw.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#define FAKE_UART_RX_SIZE 4096
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t readable;
+    int installed;
+    uint32_t baud_rate;
+    uint8_t rx[FAKE_UART_RX_SIZE];
+    size_t head;
+    size_t count;
+    fake_uart_tx_t tx;
+    void* tx_arg;
+} fake_uart_t;
+
+static fake_uart_t ports[UART_NUM_MAX];
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+static void uart_init_ports(void) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    for(int i = 0; i < UART_NUM_MAX; i++) {
+        pthread_mutex_init(&ports[i].lock, NULL);
+        pthread_cond_init(&ports[i].readable, &attr);
+    }
+    pthread_condattr_destroy(&attr);
+}
+
+static fake_uart_t* uart_port(uart_port_t port) {
+    pthread_once(&once, uart_init_ports);
+    return (port >= 0 && port < UART_NUM_MAX) ? &ports[port] : NULL;
+}
+
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t* config) {
+    fake_uart_t* uart = uart_port(port);
+    if(!uart || config->baud_rate <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uart->baud_rate = config->baud_rate;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts) {
+    return uart_port(port) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size, int queue_size, void* queue, int intr_flags) {
+    fake_uart_t* uart = uart_port(port);
+    // same limits as the real driver: both rings must be larger than the hardware fifo, tx may be 0
+    if(!uart || rx_buffer_size <= UART_HW_FIFO_LEN(port) || (tx_buffer_size > 0 && tx_buffer_size <= UART_HW_FIFO_LEN(port))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&uart->lock);
+    esp_err_t err = uart->installed ? ESP_FAIL : ESP_OK;
+    uart->installed = 1;
+    uart->head = 0;
+    uart->count = 0;
+    pthread_mutex_unlock(&uart->lock);
+    return err;
+}
+
+esp_err_t uart_driver_delete(uart_port_t port) {
+    fake_uart_t* uart = uart_port(port);
+    pthread_mutex_lock(&uart->lock);
+    uart->installed = 0;
+    pthread_mutex_unlock(&uart->lock);
+    return ESP_OK;
+}
+
+esp_err_t uart_flush_input(uart_port_t port) {
+    fake_uart_t* uart = uart_port(port);
+    pthread_mutex_lock(&uart->lock);
+    uart->head = 0;
+    uart->count = 0;
+    pthread_mutex_unlock(&uart->lock);
+    return ESP_OK;
+}
+
+esp_err_t uart_flush(uart_port_t port) {
+    return uart_flush_input(port);
+}
+
+int uart_write_bytes(uart_port_t port, const void* data, size_t len) {
+    fake_uart_t* uart = uart_port(port);
+    pthread_mutex_lock(&uart->lock);
+    fake_uart_tx_t tx = uart->tx;
+    void* arg = uart->tx_arg;
+    pthread_mutex_unlock(&uart->lock);
+
+    if(tx) {
+        tx(arg, (const uint8_t*) data, len);
+    }
+    return (int) len;
+}
+
+int uart_read_bytes(uart_port_t port, void* data, uint32_t len, TickType_t ticks) {
+    fake_uart_t* uart = uart_port(port);
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += ticks / 1000;
+    deadline.tv_nsec += (long) (ticks % 1000) * 1000000L;
+    if(deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    // like the driver, waits until all len bytes arrived or the time is up
+    uint8_t* out = (uint8_t*) data;
+    size_t received = 0;
+    pthread_mutex_lock(&uart->lock);
+    while(received < len) {
+        while(uart->count && received < len) {
+            out[received++] = uart->rx[uart->head];
+            uart->head = (uart->head + 1) % FAKE_UART_RX_SIZE;
+            uart->count--;
+        }
+        if(received == len || !ticks) {
+            break;
+        }
+        if(pthread_cond_timedwait(&uart->readable, &uart->lock, &deadline) == ETIMEDOUT) {
+            ticks = 0; // take what arrived, then stop
+        }
+    }
+    pthread_mutex_unlock(&uart->lock);
+    return (int) received;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t port, TickType_t ticks) {
+    return ESP_OK; // writes reach the device synchronously
+}
+
+esp_err_t uart_set_baudrate(uart_port_t port, uint32_t baud_rate) {
+    fake_uart_t* uart = uart_port(port);
+    if(!baud_rate) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uart->baud_rate = baud_rate;
+    return ESP_OK;
+}
+
+void fake_uart_attach(int port, fake_uart_tx_t tx, void* arg) {
+    fake_uart_t* uart = uart_port(port);
+    pthread_mutex_lock(&uart->lock);
+    uart->tx = tx;
+    uart->tx_arg = arg;
+    pthread_mutex_unlock(&uart->lock);
+}
+
+void fake_uart_inject(int port, const uint8_t* data, size_t len) {
+    fake_uart_t* uart = uart_port(port);
+    pthread_mutex_lock(&uart->lock);
+    for(size_t i = 0; i < len && uart->count < FAKE_UART_RX_SIZE; i++) {
+        uart->rx[(uart->head + uart->count) % FAKE_UART_RX_SIZE] = data[i];
+        uart->count++;
+    }
+    pthread_cond_broadcast(&uart->readable);
+    pthread_mutex_unlock(&uart->lock);
+}
@@ -0,0 +1,401 @@
+#include "pn532_sim.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fake_hw.h"
+
+#define SIM_MAX_FRAME 300
+#define SIM_RX_SIZE 600
+#define SIM_NEVER INT64_MAX
+#define SIM_POLL_PERIOD_MS 150
+
+typedef struct {
+    uint8_t data[SIM_MAX_FRAME];
+    size_t len;
+} sim_frame_t;
+
+struct pn532_sim {
+    pn532_sim_config_t config;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    bool quit;
+    bool asleep;
+
+    uint8_t rx[SIM_RX_SIZE]; // host bytes not parsed yet (UART stream)
+    size_t rx_len;
+
+    sim_frame_t pending; // response of the running command
+    int64_t pending_at; // SIM_NEVER if no command runs
+    sim_frame_t last; // last response, sent again on NACK
+
+    sim_frame_t ready; // frame waiting for the host to read it (I2C)
+    bool has_ready;
+    sim_frame_t queued; // response ready while the ACK was not read yet (I2C)
+    bool has_queued;
+
+    uint8_t registers[0x10000];
+    uint32_t counts[256];
+    uint32_t lost;
+};
+
+static const uint8_t sim_ack[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+
+static int64_t sim_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void sim_irq(pn532_sim_t* sim, int level) {
+    if(sim->config.irq_pin >= 0) {
+        fake_gpio_set_level(sim->config.irq_pin, level);
+    }
+}
+
+static void sim_build(sim_frame_t* frame, const uint8_t* data, size_t len) {
+    uint8_t* out = frame->data;
+    size_t pos = 0;
+    out[pos++] = 0x00;
+    out[pos++] = 0x00;
+    out[pos++] = 0xFF;
+    if(len > 255) {
+        out[pos++] = 0xFF;
+        out[pos++] = 0xFF;
+        out[pos++] = (uint8_t) (len >> 8);
+        out[pos++] = (uint8_t) len;
+        out[pos] = (uint8_t) -(out[pos - 2] + out[pos - 1]);
+        pos++;
+    } else {
+        out[pos++] = (uint8_t) len;
+        out[pos++] = (uint8_t) -len;
+    }
+    uint8_t sum = 0;
+    for(size_t i = 0; i < len; i++) {
+        out[pos++] = data[i];
+        sum += data[i];
+    }
+    out[pos++] = (uint8_t) -sum;
+    out[pos++] = 0x00;
+    frame->len = pos;
+}
+
+// hands a frame to the host, called with the lock held
+static void sim_emit(pn532_sim_t* sim, const uint8_t* data, size_t len) {
+    if(!sim->config.i2c) {
+        fake_uart_inject(sim->config.uart_port, data, len);
+        sim_irq(sim, 0);
+        return;
+    }
+
+    if(sim->has_ready) {
+        // the ACK is still unread, the response waits behind it
+        memcpy(sim->queued.data, data, len);
+        sim->queued.len = len;
+        sim->has_queued = true;
+        return;
+    }
+    memcpy(sim->ready.data, data, len);
+    sim->ready.len = len;
+    sim->has_ready = true;
+    sim_irq(sim, 0);
+}
+
+static void sim_schedule(pn532_sim_t* sim, const uint8_t* data, size_t len, uint32_t delay_ms) {
+    sim_build(&sim->pending, data, len);
+    sim->pending_at = sim_now_ms() + delay_ms;
+    pthread_cond_broadcast(&sim->changed);
+}
+
+static size_t sim_target_data(pn532_sim_t* sim, uint8_t* out) {
+    // Tg SENS_RES(2) SEL_RES NFCIDLength NFCID1
+    size_t pos = 0;
+    out[pos++] = 0x01;
+    out[pos++] = 0x00;
+    out[pos++] = 0x04;
+    out[pos++] = 0x08;
+    out[pos++] = sim->config.uid_len;
+    memcpy(&out[pos], sim->config.uid, sim->config.uid_len);
+    return pos + sim->config.uid_len;
+}
+
+static void sim_command(pn532_sim_t* sim, const uint8_t* data, size_t len) {
+    if(len < 2 || data[0] != 0xD4) {
+        return;
+    }
+    uint8_t command = data[1];
+    sim->counts[command]++;
+
+    // a new command replaces a running one
+    sim->pending_at = SIM_NEVER;
+    sim_emit(sim, sim_ack, sizeof(sim_ack));
+
+    uint8_t response[SIM_MAX_FRAME] = {0xD5, (uint8_t) (command + 1)};
+    size_t pos = 2;
+    uint32_t delay_ms = sim->config.response_ms;
+    switch(command) {
+        case 0x02: // GetFirmwareVersion
+            response[pos++] = 0x32;
+            response[pos++] = 0x01;
+            response[pos++] = 0x06;
+            response[pos++] = 0x07;
+            break;
+        case 0x06: // ReadRegister
+            for(size_t i = 2; i + 1 < len; i += 2) {
+                response[pos++] = sim->registers[(data[i] << 8) | data[i + 1]];
+            }
+            break;
+        case 0x08: // WriteRegister
+            for(size_t i = 2; i + 2 < len; i += 3) {
+                sim->registers[(data[i] << 8) | data[i + 1]] = data[i + 2];
+            }
+            break;
+        case 0x4A: // InListPassiveTarget
+            if(sim->config.uid_len) {
+                response[pos++] = 0x01;
+                pos += sim_target_data(sim, &response[pos]);
+                delay_ms = sim->config.detect_ms;
+            } else {
+                response[pos++] = 0x00;
+            }
+            break;
+        case 0x60: // InAutoPoll: PollNr Period Type...
+            if(sim->config.uid_len) {
+                response[pos++] = 0x01;
+                response[pos++] = 0x10;
+                size_t len_at = pos++;
+                response[len_at] = (uint8_t) sim_target_data(sim, &response[pos]);
+                pos += response[len_at];
+                delay_ms = sim->config.detect_ms;
+            } else if(len >= 4 && data[2] != 0xFF) {
+                response[pos++] = 0x00;
+                delay_ms = (uint32_t) data[2] * data[3] * (len - 4) * SIM_POLL_PERIOD_MS;
+            } else {
+                return; // endless polling of an empty field never answers
+            }
+            break;
+        default: // SAMConfiguration, RFConfiguration, ... answer without data
+            break;
+    }
+    sim_schedule(sim, response, pos, delay_ms);
+}
+
+// one complete frame from the host, called with the lock held
+static void sim_frame(pn532_sim_t* sim, const uint8_t* frame, size_t len) {
+    if(len == 6 && frame[3] == 0x00 && frame[4] == 0xFF) {
+        sim->pending_at = SIM_NEVER; // ACK aborts the running command
+        return;
+    }
+    if(len == 6 && frame[3] == 0xFF && frame[4] == 0x00) {
+        if(sim->last.len) {
+            sim_emit(sim, sim->last.data, sim->last.len); // NACK: send the last response again
+        }
+        return;
+    }
+    if(sim->asleep) {
+        sim->asleep = false; // the frame that woke the device up is lost
+        return;
+    }
+    // the I2C/UART interface raises IRQ once the host started a new exchange
+    if(!sim->config.i2c) {
+        sim_irq(sim, 1);
+    }
+    if(frame[3] == 0xFF && frame[4] == 0xFF) {
+        sim_command(sim, &frame[8], (frame[5] << 8) | frame[6]);
+    } else {
+        sim_command(sim, &frame[5], frame[3]);
+    }
+}
+
+// frame length at the start of data, 0 if incomplete, -1 if not a frame start
+static long sim_frame_len(const uint8_t* data, size_t len) {
+    if(len < 6) {
+        return 0;
+    }
+    if((data[3] == 0x00 && data[4] == 0xFF) || (data[3] == 0xFF && data[4] == 0x00)) {
+        return 6;
+    }
+    if(data[3] == 0xFF && data[4] == 0xFF) {
+        if(len < 8) {
+            return 0;
+        }
+        size_t total = 8 + ((data[5] << 8) | data[6]) + 2;
+        return (len >= total) ? (long) total : 0;
+    }
+    size_t total = 5 + data[3] + 2;
+    return (len >= total) ? (long) total : 0;
+}
+
+static void sim_parse(pn532_sim_t* sim) {
+    size_t pos = 0;
+    while(true) {
+        // frames start with 00 00 FF, the preamble and wake-up bytes in between are skipped
+        while(pos + 3 <= sim->rx_len && !(sim->rx[pos] == 0x00 && sim->rx[pos + 1] == 0x00 && sim->rx[pos + 2] == 0xFF)) {
+            pos++;
+        }
+        long len = sim_frame_len(&sim->rx[pos], sim->rx_len - pos);
+        if(len <= 0) {
+            break;
+        }
+        sim_frame(sim, &sim->rx[pos], (size_t) len);
+        pos += len;
+    }
+    memmove(sim->rx, &sim->rx[pos], sim->rx_len - pos);
+    sim->rx_len -= pos;
+}
+
+static void sim_uart_tx(void* arg, const uint8_t* data, size_t len) {
+    pn532_sim_t* sim = (pn532_sim_t*) arg;
+    pthread_mutex_lock(&sim->lock);
+    for(size_t i = 0; i < len; i++) {
+        if(sim->rx_len == SIM_RX_SIZE) {
+            sim->rx_len = 0; // garbage, start over
+        }
+        if(sim->asleep && data[i] == 0x55) {
+            sim->asleep = false;
+            continue;
+        }
+        sim->rx[sim->rx_len++] = data[i];
+        sim_parse(sim);
+    }
+    pthread_mutex_unlock(&sim->lock);
+}
+
+static void sim_i2c_write(void* arg, const uint8_t* data, size_t len) {
+    pn532_sim_t* sim = (pn532_sim_t*) arg;
+    pthread_mutex_lock(&sim->lock);
+    // a frame the host did not read is gone once it writes again
+    if(sim->has_ready) {
+        sim->lost++;
+    }
+    sim->has_ready = false;
+    sim->has_queued = false;
+    sim_irq(sim, 1);
+
+    long frame_len = (len >= 3) ? sim_frame_len(data, len) : -1;
+    if(frame_len > 0) {
+        sim_frame(sim, data, (size_t) frame_len);
+    }
+    pthread_mutex_unlock(&sim->lock);
+}
+
+static void sim_i2c_read(void* arg, uint8_t* data, size_t len) {
+    pn532_sim_t* sim = (pn532_sim_t*) arg;
+    pthread_mutex_lock(&sim->lock);
+    memset(data, 0, len);
+    if(!sim->has_ready) {
+        pthread_mutex_unlock(&sim->lock);
+        return; // status 0x00, not ready
+    }
+
+    data[0] = 0x01;
+    if(len > 1) {
+        // the frame is shifted out once, the next read starts on the next frame (or not ready)
+        size_t copy = (len - 1 < sim->ready.len) ? len - 1 : sim->ready.len;
+        memcpy(&data[1], sim->ready.data, copy);
+        sim->has_ready = sim->has_queued;
+        if(sim->has_queued) {
+            sim->ready = sim->queued;
+            sim->has_queued = false;
+        } else {
+            sim_irq(sim, 1);
+        }
+    }
+    pthread_mutex_unlock(&sim->lock);
+}
+
+static void* sim_thread(void* arg) {
+    pn532_sim_t* sim = (pn532_sim_t*) arg;
+    pthread_mutex_lock(&sim->lock);
+    while(!sim->quit) {
+        int64_t now = sim_now_ms();
+        if(sim->pending_at <= now) {
+            sim->pending_at = SIM_NEVER;
+            sim->last = sim->pending;
+            sim_emit(sim, sim->pending.data, sim->pending.len);
+            continue;
+        }
+
+        if(sim->pending_at == SIM_NEVER) {
+            pthread_cond_wait(&sim->changed, &sim->lock);
+        } else {
+            struct timespec deadline = {
+                .tv_sec = sim->pending_at / 1000,
+                .tv_nsec = (long) (sim->pending_at % 1000) * 1000000L,
+            };
+            (void) pthread_cond_timedwait(&sim->changed, &sim->lock, &deadline);
+        }
+    }
+    pthread_mutex_unlock(&sim->lock);
+    return NULL;
+}
+
+pn532_sim_t* pn532_sim_create(const pn532_sim_config_t* config) {
+    pn532_sim_t* sim = calloc(1, sizeof(pn532_sim_t));
+    if(!sim) {
+        return NULL;
+    }
+    sim->config = *config;
+    sim->pending_at = SIM_NEVER;
+    sim->asleep = config->asleep && !config->i2c;
+    pthread_mutex_init(&sim->lock, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&sim->changed, &attr);
+    pthread_condattr_destroy(&attr);
+
+    sim_irq(sim, 1);
+    if(config->i2c) {
+        const fake_i2c_device_t device = {
+            .write = sim_i2c_write,
+            .read = sim_i2c_read,
+            .arg = sim,
+        };
+        fake_i2c_attach(&device);
+    } else {
+        fake_uart_attach(config->uart_port, sim_uart_tx, sim);
+    }
+
+    if(pthread_create(&sim->thread, NULL, sim_thread, sim) != 0) {
+        free(sim);
+        return NULL;
+    }
+    return sim;
+}
+
+void pn532_sim_destroy(pn532_sim_t* sim) {
+    if(sim->config.i2c) {
+        fake_i2c_attach(NULL);
+    } else {
+        fake_uart_attach(sim->config.uart_port, NULL, NULL);
+    }
+
+    pthread_mutex_lock(&sim->lock);
+    sim->quit = true;
+    pthread_cond_broadcast(&sim->changed);
+    pthread_mutex_unlock(&sim->lock);
+    pthread_join(sim->thread, NULL);
+
+    pthread_cond_destroy(&sim->changed);
+    pthread_mutex_destroy(&sim->lock);
+    free(sim);
+}
+
+uint32_t pn532_sim_count(pn532_sim_t* sim, uint8_t command) {
+    pthread_mutex_lock(&sim->lock);
+    uint32_t count = sim->counts[command];
+    pthread_mutex_unlock(&sim->lock);
+    return count;
+}
+
+uint32_t pn532_sim_lost(pn532_sim_t* sim) {
+    pthread_mutex_lock(&sim->lock);
+    uint32_t lost = sim->lost;
+    pthread_mutex_unlock(&sim->lock);
+    return lost;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+// PN532 simulated behind a fake UART port or the fake I2C bus: answers host frames with an ACK
+// and, after a processing delay, a response. Only the commands the host tests use are modeled.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct pn532_sim pn532_sim_t;
+
+typedef struct {
+    bool i2c; // attach to the fake I2C bus, otherwise to uart_port
+    int uart_port;
+    int irq_pin; // IRQ line driven by the device, -1 if not wired
+    bool asleep; // HSU power-on state: the first frame (or a 0x55) only wakes the device up (UART only)
+    uint32_t response_ms; // processing time of ordinary commands
+    uint32_t detect_ms; // time InListPassiveTarget/InAutoPoll need to report the card in the field
+    uint8_t uid[10]; // card in the field
+    uint8_t uid_len; // 0 for an empty field
+} pn532_sim_config_t;
+
+pn532_sim_t* pn532_sim_create(const pn532_sim_config_t* config);
+void pn532_sim_destroy(pn532_sim_t* sim);
+
+// command frames received with this command code
+uint32_t pn532_sim_count(pn532_sim_t* sim, uint8_t command);
+
+// frames (ACK or response) the device has lost because the host never read them (I2C only)
+uint32_t pn532_sim_lost(pn532_sim_t* sim);
@@ -0,0 +1,104 @@
+// pn532_write_frame (iovec, no payload copy) against the previous framing, which copied the command
+// into a VLA frame before handing it to the driver. Both write into a sink that stands in for the
+// driver's copy into its tx ring buffer, so only the framing differs. Frames must come out identical.
+
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <string.h>
+
+#include "test_host.h"
+
+#define ITERATIONS 200000
+
+extern esp_err_t pn532_write_frame(pn532_t* pn532, const uint8_t* command, size_t command_len, const uint8_t* data, size_t data_len);
+
+static uint8_t sink[PN532_EXTENDED_BUFFER_SIZE];
+static size_t sink_len;
+
+static esp_err_t sink_write_frame(pn532_t* pn532, const pn532_iovec_t* iov, size_t iov_count) {
+    sink_len = 0;
+    for(size_t i = 0; i < iov_count; i++) {
+        memcpy(&sink[sink_len], iov[i].data, iov[i].len);
+        sink_len += iov[i].len;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sink_write_raw(pn532_t* pn532, const uint8_t* data, size_t len) {
+    memcpy(sink, data, len);
+    sink_len = len;
+    return ESP_OK;
+}
+
+// framing before the iovec change (normal frames only), its VLA was one byte short of the postamble
+static esp_err_t copy_write_command(pn532_t* pn532, const uint8_t* command, uint8_t command_len) {
+    size_t data_len = command_len + 1;
+    uint8_t cmd[data_len + 7];
+
+    cmd[0] = PN532_PREAMBLE;
+    cmd[1] = PN532_STARTCODE1;
+    cmd[2] = PN532_STARTCODE2;
+    cmd[3] = data_len;
+    cmd[4] = ~data_len + 1;
+    cmd[5] = PN532_HOSTTOPN532;
+
+    for(size_t i = 0; i < command_len; i++) {
+        cmd[6 + i] = command[i];
+    }
+
+    uint8_t checksum = PN532_HOSTTOPN532;
+    for(size_t i = 0; i < command_len; i++) {
+        checksum += command[i];
+    }
+    checksum = ~checksum + 1;
+
+    cmd[6 + command_len] = checksum;
+    cmd[7 + command_len] = PN532_POSTAMBLE;
+
+    return pn532->write_raw(pn532, cmd, sizeof(cmd));
+}
+
+static double ns_per_frame(int64_t start_us) {
+    return (double) (esp_timer_get_time() - start_us) * 1000.0 / ITERATIONS;
+}
+
+static void bench(pn532_t* pn532, size_t len) {
+    uint8_t command[250];
+    for(size_t i = 0; i < sizeof(command); i++) {
+        command[i] = (uint8_t) (i * 7 + 1);
+    }
+
+    uint8_t expected[PN532_EXTENDED_BUFFER_SIZE];
+    CHECK_ERR(ESP_OK, copy_write_command(pn532, command, len));
+    memcpy(expected, sink, sink_len);
+    size_t expected_len = sink_len;
+
+    CHECK_ERR(ESP_OK, pn532_write_frame(pn532, command, len, NULL, 0));
+    CHECK(sink_len == expected_len && !memcmp(sink, expected, expected_len));
+
+    int64_t start = esp_timer_get_time();
+    for(int i = 0; i < ITERATIONS; i++) {
+        (void) copy_write_command(pn532, command, len);
+    }
+    double copy_ns = ns_per_frame(start);
+
+    start = esp_timer_get_time();
+    for(int i = 0; i < ITERATIONS; i++) {
+        (void) pn532_write_frame(pn532, command, len, NULL, 0);
+    }
+    double iovec_ns = ns_per_frame(start);
+
+    printf("%3d byte command: copy %7.1f ns, iovec %7.1f ns per frame\n", (int) len, copy_ns, iovec_ns);
+}
+
+int main(void) {
+    static pn532_t pn532 = {
+        .write_frame = sink_write_frame,
+        .write_raw = sink_write_raw,
+    };
+
+    bench(&pn532, 1);
+    bench(&pn532, 250);
+    return 0;
+}
@@ -0,0 +1,135 @@
+// async worker: nothing queued may be left waiting once the handle is freed, and callbacks may call accessors
+
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "freertos/task.h"
+
+#include "test_host.h"
+
+#define UART_PORT 2
+#define REQUESTS 6
+
+static atomic_int completed;
+static atomic_int cancelled;
+
+static void on_complete(pn532_handle_t pn532_handle, esp_err_t err, const uint8_t* response, size_t response_len, void* arg) {
+    // nothing answers on the port, so every command that runs times out
+    CHECK(err == ESP_ERR_TIMEOUT || err == ESP_ERR_INVALID_STATE);
+    CHECK(!response && !response_len);
+    if(err == ESP_ERR_INVALID_STATE) {
+        atomic_fetch_add(&cancelled, 1);
+    }
+    atomic_fetch_add(&completed, 1);
+}
+
+static pn532_handle_t init_async(void) {
+    const pn532_config_t config = {
+        .protocol = PN532_UART_PROTOCOL,
+        .uart = {
+            .tx = 17,
+            .rx = 16,
+            .uart_port = UART_PORT,
+            .baud_rate = 115200,
+        },
+        .async = {
+            .enabled = true,
+        },
+    };
+    pn532_handle_t handle = NULL;
+    CHECK_ERR(ESP_OK, pn532_init(&handle, &config));
+    return handle;
+}
+
+static void test_free_cancels_queued(void) {
+    atomic_store(&completed, 0);
+    atomic_store(&cancelled, 0);
+    pn532_handle_t handle = init_async();
+
+    uint8_t command[] = {PN532_COMMAND_GETFIRMWAREVERSION};
+    for(int i = 0; i < REQUESTS; i++) {
+        CHECK_ERR(ESP_OK, pn532_submit_command(handle, command, sizeof(command), 50, (i & 1) ? PN532_PRIORITY_HIGH : PN532_PRIORITY_NORMAL, on_complete, NULL));
+    }
+
+    // the worker stops after its current request instead of working through the queue
+    int64_t start = esp_timer_get_time();
+    CHECK_ERR(ESP_OK, pn532_free(handle));
+    CHECK(elapsed_ms(start) < 200);
+    CHECK(atomic_load(&completed) == REQUESTS);
+    CHECK(atomic_load(&cancelled) >= REQUESTS - 1);
+}
+
+typedef struct {
+    pn532_handle_t handle;
+    esp_err_t err;
+} caller_t;
+
+static void* caller_thread(void* arg) {
+    caller_t* caller = (caller_t*) arg;
+    uint8_t version[4];
+    caller->err = pn532_get_firmware_version(caller->handle, version);
+    return NULL;
+}
+
+static void test_free_releases_waiters(void) {
+    pn532_handle_t handle = init_async();
+
+    // one request runs, the others wait in the queue while the handle is freed
+    caller_t callers[3];
+    pthread_t threads[3];
+    for(int i = 0; i < 3; i++) {
+        callers[i] = (caller_t) {.handle = handle, .err = ESP_OK};
+        CHECK(pthread_create(&threads[i], NULL, caller_thread, &callers[i]) == 0);
+    }
+    vTaskDelay(pdMS_TO_TICKS(10));
+
+    CHECK_ERR(ESP_OK, pn532_free(handle));
+    for(int i = 0; i < 3; i++) {
+        pthread_join(threads[i], NULL);
+        CHECK(callers[i].err != ESP_OK);
+    }
+}
+
+typedef struct {
+    SemaphoreHandle_t done;
+    esp_err_t reset_err;
+    esp_err_t lowpower_err;
+    int64_t elapsed;
+} accessor_calls_t;
+
+static void on_complete_call_accessors(pn532_handle_t pn532_handle, esp_err_t err, const uint8_t* response, size_t response_len, void* arg) {
+    // runs on the worker with the handle mutex held
+    accessor_calls_t* calls = (accessor_calls_t*) arg;
+    int64_t start = esp_timer_get_time();
+    calls->reset_err = pn532_reset_stats(pn532_handle);
+    pn532_lowpower_stats_t lowpower;
+    calls->lowpower_err = pn532_get_lowpower_stats(pn532_handle, &lowpower);
+    calls->elapsed = elapsed_ms(start);
+    xSemaphoreGive(calls->done);
+}
+
+static void test_accessors_from_callback(void) {
+    pn532_handle_t handle = init_async();
+
+    accessor_calls_t calls = {.done = xSemaphoreCreateBinary()};
+    uint8_t command[] = {PN532_COMMAND_GETFIRMWAREVERSION};
+    CHECK_ERR(ESP_OK, pn532_submit_command(handle, command, sizeof(command), 20, PN532_PRIORITY_NORMAL, on_complete_call_accessors, &calls));
+    CHECK(xSemaphoreTake(calls.done, pdMS_TO_TICKS(2000)) == pdTRUE);
+
+    CHECK_ERR(ESP_OK, calls.reset_err);
+    CHECK_ERR(ESP_OK, calls.lowpower_err);
+    CHECK(calls.elapsed < 100);
+
+    vSemaphoreDelete(calls.done);
+    CHECK_ERR(ESP_OK, pn532_free(handle));
+}
+
+int main(void) {
+    RUN(test_free_cancels_queued);
+    RUN(test_free_releases_waiters);
+    RUN(test_accessors_from_callback);
+    return 0;
+}
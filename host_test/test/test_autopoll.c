@@ -0,0 +1,92 @@
+// endless autopoll must give the handle up to other commands and carry on afterwards
+
+#include "pn532.h"
+
+#include "freertos/task.h"
+
+#include "pn532_sim.h"
+#include "test_host.h"
+
+#define UART_PORT 3
+
+static pn532_handle_t init_reader(bool async) {
+    const pn532_config_t config = {
+        .protocol = PN532_UART_PROTOCOL,
+        .uart = {
+            .tx = 17,
+            .rx = 16,
+            .uart_port = UART_PORT,
+            .baud_rate = 115200,
+        },
+        .async = {
+            .enabled = async,
+        },
+    };
+    pn532_handle_t handle = NULL;
+    CHECK_ERR(ESP_OK, pn532_init(&handle, &config));
+    return handle;
+}
+
+static void check_commands_during_endless_poll(bool async) {
+    const pn532_sim_config_t sim_config = {
+        .uart_port = UART_PORT,
+        .irq_pin = -1,
+        .response_ms = 2,
+    };
+    pn532_sim_t* sim = pn532_sim_create(&sim_config);
+    CHECK(sim);
+    pn532_handle_t handle = init_reader(async);
+
+    const pn532_autopoll_config_t autopoll = {
+        .types = {PN532_AUTOPOLL_MIFARE},
+        .num_types = 1,
+        .poll_count = 0xFF, // endless, an empty field never answers
+        .period = 1,
+    };
+    QueueHandle_t events = NULL;
+    CHECK_ERR(ESP_OK, pn532_autopoll_start(handle, &autopoll, &events));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    CHECK(pn532_sim_count(sim, PN532_COMMAND_INAUTOPOLL) == 1);
+
+    for(int i = 0; i < 3; i++) {
+        // waits at most one slice for the running cycle to be aborted
+        uint8_t version[4];
+        int64_t start = esp_timer_get_time();
+        CHECK_ERR(ESP_OK, pn532_get_firmware_version(handle, version));
+        CHECK(elapsed_ms(start) < 200);
+        CHECK(version[0] == 0x32);
+        vTaskDelay(pdMS_TO_TICKS(30));
+    }
+
+    // polling was taken up again after every command
+    CHECK(pn532_sim_count(sim, PN532_COMMAND_GETFIRMWAREVERSION) == 3);
+    CHECK(pn532_sim_count(sim, PN532_COMMAND_INAUTOPOLL) == 4);
+
+    // accessors that never reach the PN532 interrupt the cycle the same way
+    int64_t start = esp_timer_get_time();
+    CHECK_ERR(ESP_OK, pn532_reset_stats(handle));
+    CHECK(elapsed_ms(start) < 200);
+
+    pn532_lowpower_stats_t lowpower;
+    start = esp_timer_get_time();
+    CHECK_ERR(ESP_OK, pn532_get_lowpower_stats(handle, &lowpower));
+    CHECK(elapsed_ms(start) < 200);
+
+    CHECK_ERR(ESP_OK, pn532_autopoll_stop(handle));
+    CHECK_ERR(ESP_OK, pn532_free(handle));
+    pn532_sim_destroy(sim);
+}
+
+static void test_endless_poll_sync(void) {
+    check_commands_during_endless_poll(false);
+}
+
+static void test_endless_poll_async(void) {
+    check_commands_during_endless_poll(true);
+}
+
+int main(void) {
+    RUN(test_endless_poll_sync);
+    RUN(test_endless_poll_async);
+    return 0;
+}
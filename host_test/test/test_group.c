@@ -0,0 +1,117 @@
+// reader group against 1 to PN532_GROUP_MAX_READERS simulated devices: every reader polls on its own
+// task, so detections must scale with the number of readers and carry the right reader tag
+
+#include "pn532.h"
+
+#include "freertos/task.h"
+
+#include "pn532_sim.h"
+#include "test_host.h"
+
+#define FIRST_PORT 4
+#define DETECT_MS 20
+#define RUN_MS 500
+
+typedef struct {
+    uint32_t events[PN532_GROUP_MAX_READERS];
+    uint32_t total;
+} run_result_t;
+
+static run_result_t run_group(size_t num_readers) {
+    pn532_sim_t* sims[PN532_GROUP_MAX_READERS];
+    pn532_group_config_t config = {
+        .num_readers = num_readers,
+        .autopoll = {
+            .types = {PN532_AUTOPOLL_MIFARE},
+            .num_types = 1,
+            .poll_count = 1,
+            .period = 1,
+            .queue_len = 32,
+        },
+    };
+    for(size_t i = 0; i < num_readers; i++) {
+        // each device has its own card, uid[0] tells them apart
+        pn532_sim_config_t sim_config = {
+            .uart_port = FIRST_PORT + i,
+            .irq_pin = -1,
+            .asleep = true, // pn532_group_start() wakes it up
+            .response_ms = 1,
+            .detect_ms = DETECT_MS,
+            .uid = {(uint8_t) i, 0xDE, 0xAD, 0x01},
+            .uid_len = 4,
+        };
+        sims[i] = pn532_sim_create(&sim_config);
+        CHECK(sims[i]);
+
+        config.readers[i].config = (pn532_config_t) {
+            .protocol = PN532_UART_PROTOCOL,
+            .uart = {
+                .tx = 17,
+                .rx = 16,
+                .uart_port = FIRST_PORT + i,
+                .baud_rate = 115200,
+            },
+        };
+        config.readers[i].task_core = tskNO_AFFINITY;
+    }
+
+    pn532_group_handle_t group = NULL;
+    CHECK_ERR(ESP_OK, pn532_group_init(&group, &config));
+    QueueHandle_t events = NULL;
+    CHECK_ERR(ESP_OK, pn532_group_start(group, &events));
+
+    run_result_t result = {0};
+    int64_t start = esp_timer_get_time();
+    while(elapsed_ms(start) < RUN_MS) {
+        pn532_scan_event_t event;
+        if(xQueueReceive(events, &event, pdMS_TO_TICKS(10)) != pdTRUE) {
+            continue;
+        }
+        CHECK(event.reader < num_readers);
+        CHECK(event.kind == PN532_SCAN_DETECTED);
+        CHECK(event.target.uid_len == 4 && event.target.uid[0] == event.reader);
+        result.events[event.reader]++;
+        result.total++;
+    }
+
+    CHECK_ERR(ESP_OK, pn532_group_stop(group));
+
+    // every event that arrived was counted (readers stopped later post a few more), none was dropped
+    pn532_group_stats_t stats;
+    CHECK_ERR(ESP_OK, pn532_group_get_stats(group, &stats));
+    CHECK(stats.num_readers == num_readers);
+    for(size_t i = 0; i < num_readers; i++) {
+        CHECK(stats.dropped[i] == 0);
+        CHECK(stats.events[i] >= result.events[i]);
+        CHECK(result.events[i] > 0);
+    }
+
+    CHECK_ERR(ESP_OK, pn532_group_free(group));
+    for(size_t i = 0; i < num_readers; i++) {
+        pn532_sim_destroy(sims[i]);
+    }
+    return result;
+}
+
+static void test_scaling(void) {
+    uint32_t single = 0;
+    for(size_t readers = 1; readers <= PN532_GROUP_MAX_READERS; readers++) {
+        run_result_t result = run_group(readers);
+        printf("%d reader(s): %lu events in %d ms\n", (int) readers, (unsigned long) result.total, RUN_MS);
+        if(readers == 1) {
+            single = result.total;
+            continue;
+        }
+
+        // readers don't wait on each other, allow some loss to host scheduling
+        CHECK(result.total * 4 >= single * readers * 3);
+        for(size_t i = 0; i < readers; i++) {
+            CHECK(result.events[i] * 2 >= single);
+        }
+    }
+}
+
+int main(void) {
+    RUN(test_scaling);
+    return 0;
+}
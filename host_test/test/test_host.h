@@ -0,0 +1,34 @@
+#pragma once
+
+// minimal test runner for the host tests, a failed check ends the test with a message
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "esp_err.h"
+#include "esp_timer.h"
+
+#define CHECK(cond) do { \
+    if(!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1); \
+    } \
+} while(0)
+
+#define CHECK_ERR(expected, expr) do { \
+    esp_err_t err_ = (expr); \
+    if(err_ != (expected)) { \
+        fprintf(stderr, "%s:%d: %s returned %s, expected %s\n", __FILE__, __LINE__, #expr, esp_err_to_name(err_), esp_err_to_name(expected)); \
+        exit(1); \
+    } \
+} while(0)
+
+#define RUN(test) do { \
+    printf("%s\n", #test); \
+    fflush(stdout); \
+    test(); \
+} while(0)
+
+static inline int64_t elapsed_ms(int64_t since_us) {
+    return (esp_timer_get_time() - since_us) / 1000;
+}
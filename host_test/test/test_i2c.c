@@ -0,0 +1,74 @@
+// I2C frames against a simulated PN532 that shifts each frame out only once
+
+#include "pn532.h"
+
+#include "pn532_sim.h"
+#include "test_host.h"
+
+#define IRQ_PIN 5
+
+static void check_reader(bool use_irq) {
+    const pn532_sim_config_t sim_config = {
+        .i2c = true,
+        .irq_pin = use_irq ? IRQ_PIN : -1,
+        .response_ms = 2,
+    };
+    pn532_sim_t* sim = pn532_sim_create(&sim_config);
+    CHECK(sim);
+
+    const pn532_config_t config = {
+        .protocol = PN532_I2C_PROTOCOL,
+        .i2c = {
+            .sda = 21,
+            .scl = 22,
+            .clk_speed = 400000,
+            .irq = IRQ_PIN,
+            .use_irq = use_irq,
+        },
+    };
+    pn532_handle_t handle = NULL;
+    CHECK_ERR(ESP_OK, pn532_init(&handle, &config));
+
+    // short response, read with its status byte in one transaction
+    uint8_t version[4];
+    CHECK_ERR(ESP_OK, pn532_get_firmware_version(handle, version));
+    CHECK(version[0] == 0x32 && version[1] == 0x01 && version[2] == 0x06);
+
+    // SFR addresses, so the values come from the device and not the CIU cache
+    pn532_register_t registers[60];
+    uint16_t addresses[60];
+    for(size_t i = 0; i < 60; i++) {
+        addresses[i] = 0xFF00 + i;
+        registers[i] = (pn532_register_t) {.address = addresses[i], .value = (uint8_t) (0xA0 ^ i)};
+    }
+    size_t written = 0;
+    CHECK_ERR(ESP_OK, pn532_write_registers(handle, registers, 60, &written));
+    CHECK(written == 60);
+
+    // a 60 byte response is longer than the first read and comes whole after a nack
+    uint8_t values[60];
+    CHECK_ERR(ESP_OK, pn532_read_registers(handle, addresses, values, 60));
+    for(size_t i = 0; i < 60; i++) {
+        CHECK(values[i] == (uint8_t) (0xA0 ^ i));
+    }
+
+    // every frame the device sent was read
+    CHECK(pn532_sim_lost(sim) == 0);
+
+    CHECK_ERR(ESP_OK, pn532_free(handle));
+    pn532_sim_destroy(sim);
+}
+
+static void test_polled(void) {
+    check_reader(false);
+}
+
+static void test_irq(void) {
+    check_reader(true);
+}
+
+int main(void) {
+    RUN(test_polled);
+    RUN(test_irq);
+    return 0;
+}
@@ -0,0 +1,152 @@
+// IRQ wait against a simulated IRQ line, driven from another thread like the PN532 would
+
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <pthread.h>
+
+#include "freertos/task.h"
+
+#include "fake_hw.h"
+#include "test_host.h"
+
+#define IRQ_PIN 4
+#define UART_PORT 1
+#define SLACK_MS 15 // scheduling noise on a loaded host
+
+extern esp_err_t pn532_irq_wait(pn532_t* pn532, TickType_t timeout);
+extern esp_err_t pn532_read_response(pn532_t* pn532, uint32_t timeout);
+
+typedef struct {
+    uint32_t delay_ms;
+    const uint8_t* frame; // written to the UART right after the edge (can be NULL)
+    size_t frame_len;
+} edge_t;
+
+static void* edge_thread(void* arg) {
+    const edge_t* edge = (const edge_t*) arg;
+    vTaskDelay(pdMS_TO_TICKS(edge->delay_ms));
+    fake_gpio_set_level(IRQ_PIN, 0);
+    if(edge->frame) {
+        fake_uart_inject(UART_PORT, edge->frame, edge->frame_len);
+    }
+    return NULL;
+}
+
+static pthread_t edge_after(const edge_t* edge) {
+    pthread_t thread;
+    CHECK(pthread_create(&thread, NULL, edge_thread, (void*) edge) == 0);
+    return thread;
+}
+
+static pn532_handle_t handle;
+
+static void test_timeout_while_high(void) {
+    fake_gpio_set_level(IRQ_PIN, 1);
+
+    int64_t start = esp_timer_get_time();
+    CHECK_ERR(ESP_ERR_TIMEOUT, pn532_irq_wait(handle, pdMS_TO_TICKS(50)));
+    int64_t elapsed = elapsed_ms(start);
+    CHECK(elapsed >= 49 && elapsed <= 50 + SLACK_MS);
+}
+
+static void test_edge_wakes_waiter(void) {
+    fake_gpio_set_level(IRQ_PIN, 1);
+
+    const edge_t edge = {.delay_ms = 20};
+    pthread_t thread = edge_after(&edge);
+
+    int64_t start = esp_timer_get_time();
+    CHECK_ERR(ESP_OK, pn532_irq_wait(handle, pdMS_TO_TICKS(500)));
+    int64_t elapsed = elapsed_ms(start);
+    CHECK(elapsed >= 19 && elapsed <= 20 + SLACK_MS);
+
+    pthread_join(thread, NULL);
+}
+
+static void test_already_low(void) {
+    // the edge came before the wait was armed, the level check must catch it
+    fake_gpio_set_level(IRQ_PIN, 1);
+    fake_gpio_set_level(IRQ_PIN, 0);
+
+    int64_t start = esp_timer_get_time();
+    CHECK_ERR(ESP_OK, pn532_irq_wait(handle, pdMS_TO_TICKS(500)));
+    CHECK(elapsed_ms(start) <= SLACK_MS);
+}
+
+static void test_stale_edge_dropped(void) {
+    // a notification left over from an earlier frame must not end the next wait early
+    fake_gpio_set_level(IRQ_PIN, 1);
+    (void) xTaskNotifyGiveIndexed(xTaskGetCurrentTaskHandle(), PN532_IRQ_NOTIFY_INDEX);
+
+    int64_t start = esp_timer_get_time();
+    CHECK_ERR(ESP_ERR_TIMEOUT, pn532_irq_wait(handle, pdMS_TO_TICKS(30)));
+    CHECK(elapsed_ms(start) >= 29);
+}
+
+static void test_worker_wakeup_kept(void) {
+    // a request submitted to the async worker during the wait neither ends it nor gets lost
+    fake_gpio_set_level(IRQ_PIN, 1);
+    (void) xTaskNotifyGive(xTaskGetCurrentTaskHandle());
+
+    int64_t start = esp_timer_get_time();
+    CHECK_ERR(ESP_ERR_TIMEOUT, pn532_irq_wait(handle, pdMS_TO_TICKS(30)));
+    CHECK(elapsed_ms(start) >= 29);
+    CHECK(ulTaskNotifyTake(pdTRUE, 0) == 1);
+}
+
+static void test_response_after_edge(void) {
+    fake_gpio_set_level(IRQ_PIN, 1);
+
+    // GetFirmwareVersion response
+    static const uint8_t frame[] = {0x00, 0x00, 0xFF, 0x06, 0xFA, 0xD5, 0x03, 0x32, 0x01, 0x06, 0x07, 0xE8, 0x00};
+    const edge_t edge = {.delay_ms = 20, .frame = frame, .frame_len = sizeof(frame)};
+    pthread_t thread = edge_after(&edge);
+
+    CHECK_ERR(ESP_OK, pn532_read_response(handle, 200));
+    CHECK(handle->response_data_len == 6);
+    CHECK(handle->response_data[0] == 0xD5 && handle->response_data[1] == 0x03);
+
+    pthread_join(thread, NULL);
+}
+
+static void test_late_edge_keeps_timeout(void) {
+    // the IRQ comes late and the frame never does: the whole read still ends at the timeout
+    fake_gpio_set_level(IRQ_PIN, 1);
+
+    const edge_t edge = {.delay_ms = 70};
+    pthread_t thread = edge_after(&edge);
+
+    int64_t start = esp_timer_get_time();
+    CHECK_ERR(ESP_ERR_TIMEOUT, pn532_read_response(handle, 100));
+    int64_t elapsed = elapsed_ms(start);
+    CHECK(elapsed >= 99 && elapsed <= 100 + SLACK_MS);
+
+    pthread_join(thread, NULL);
+}
+
+int main(void) {
+    const pn532_config_t config = {
+        .protocol = PN532_UART_PROTOCOL,
+        .uart = {
+            .tx = 17,
+            .rx = 16,
+            .uart_port = UART_PORT,
+            .baud_rate = 115200,
+            .irq = IRQ_PIN,
+            .use_irq = true,
+        },
+    };
+    CHECK_ERR(ESP_OK, pn532_init(&handle, &config));
+
+    RUN(test_timeout_while_high);
+    RUN(test_edge_wakes_waiter);
+    RUN(test_already_low);
+    RUN(test_stale_edge_dropped);
+    RUN(test_worker_wakeup_kept);
+    RUN(test_response_after_edge);
+    RUN(test_late_edge_keeps_timeout);
+
+    CHECK_ERR(ESP_OK, pn532_free(handle));
+    return 0;
+}
@@ -0,0 +1,75 @@
+// CIU shadow cache against a simulated PN532: it only survives register reads and writes
+
+#include "pn532.h"
+
+#include "pn532_sim.h"
+#include "test_host.h"
+
+#define UART_PORT 2
+#define COUNT 4
+
+static pn532_handle_t handle;
+
+static const pn532_register_t registers[COUNT] = {
+    {.address = PN532_CIU_BASE + 0x01, .value = 0x80},
+    {.address = PN532_CIU_BASE + 0x02, .value = 0x80},
+    {.address = PN532_CIU_BASE + 0x05, .value = 0x10},
+    {.address = PN532_CIU_BASE + 0x06, .value = 0x03},
+};
+
+static size_t write_all(void) {
+    size_t written = 0;
+    CHECK_ERR(ESP_OK, pn532_write_registers(handle, registers, COUNT, &written));
+    return written;
+}
+
+static void test_unchanged_skipped(void) {
+    CHECK_ERR(ESP_OK, pn532_invalidate_register_cache(handle));
+    CHECK(write_all() == COUNT);
+    CHECK(write_all() == 0);
+}
+
+static void test_read_keeps_cache(void) {
+    CHECK(write_all() == 0);
+    const uint16_t address = PN532_CIU_BASE + 0x01;
+    uint8_t value = 0;
+    CHECK_ERR(ESP_OK, pn532_read_registers(handle, &address, &value, 1));
+    CHECK(write_all() == 0);
+}
+
+static void test_command_drops_cache(void) {
+    // the firmware may have rewritten any CIU register while running the command
+    CHECK(write_all() == 0);
+    uint8_t version[4];
+    CHECK_ERR(ESP_OK, pn532_get_firmware_version(handle, version));
+    CHECK(write_all() == COUNT);
+}
+
+int main(void) {
+    const pn532_sim_config_t sim_config = {
+        .uart_port = UART_PORT,
+        .irq_pin = -1,
+        .response_ms = 1,
+    };
+    pn532_sim_t* sim = pn532_sim_create(&sim_config);
+    CHECK(sim);
+
+    const pn532_config_t config = {
+        .protocol = PN532_UART_PROTOCOL,
+        .uart = {
+            .tx = 17,
+            .rx = 16,
+            .uart_port = UART_PORT,
+            .baud_rate = 115200,
+        },
+    };
+    CHECK_ERR(ESP_OK, pn532_init(&handle, &config));
+
+    RUN(test_unchanged_skipped);
+    RUN(test_read_keeps_cache);
+    RUN(test_command_drops_cache);
+
+    CHECK_ERR(ESP_OK, pn532_free(handle));
+    pn532_sim_destroy(sim);
+    return 0;
+}
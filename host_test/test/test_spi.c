@@ -0,0 +1,77 @@
+// SPI frame writes against the bus limits of a handle-owned bus
+
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <string.h>
+
+#include "fake_hw.h"
+#include "test_host.h"
+
+#define PN532_SPI_DATAWRITE 0x01
+
+extern esp_err_t pn532_write_frame(pn532_t* pn532, const uint8_t* command, size_t command_len, const uint8_t* data, size_t data_len);
+
+static pn532_handle_t handle;
+static uint8_t written[512];
+static size_t written_len;
+
+static void device_write(void* arg, uint8_t cmd, const uint8_t* data, size_t len) {
+    if(cmd == PN532_SPI_DATAWRITE && len <= sizeof(written)) {
+        memcpy(written, data, len);
+        written_len = len;
+    }
+}
+
+static void test_largest_extended_frame(void) {
+    // TgSetData with the largest payload: TFI + command + data fill the extended frame LEN
+    static uint8_t data[PN532_MAX_FRAME_DATA - 2];
+    for(size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t) i;
+    }
+    const uint8_t command[] = {PN532_COMMAND_TGSETDATA};
+
+    written_len = 0;
+    CHECK_ERR(ESP_OK, pn532_write_frame(handle, command, sizeof(command), data, sizeof(data)));
+
+    // 00 00 FF FF FF LENm LENl LCS + LEN + DCS + postamble
+    CHECK(written_len == 8 + PN532_MAX_FRAME_DATA + 2);
+    CHECK(written[3] == 0xFF && written[4] == 0xFF);
+    CHECK(((written[5] << 8) | written[6]) == PN532_MAX_FRAME_DATA);
+    CHECK(written[8] == PN532_HOSTTOPN532 && written[9] == PN532_COMMAND_TGSETDATA);
+    CHECK(memcmp(&written[10], data, sizeof(data)) == 0);
+    CHECK(written[written_len - 1] == PN532_POSTAMBLE);
+}
+
+static void test_too_long_rejected(void) {
+    static uint8_t data[PN532_MAX_FRAME_DATA - 1];
+    const uint8_t command[] = {PN532_COMMAND_TGSETDATA};
+
+    written_len = 0;
+    CHECK_ERR(ESP_ERR_INVALID_SIZE, pn532_write_frame(handle, command, sizeof(command), data, sizeof(data)));
+    CHECK(written_len == 0);
+}
+
+int main(void) {
+    const fake_spi_device_t device = {.write = device_write};
+    fake_spi_attach(&device);
+
+    const pn532_config_t config = {
+        .protocol = PN532_SPI_PROTOCOL,
+        .spi = {
+            .miso = 19,
+            .mosi = 23,
+            .sclk = 18,
+            .cs = 5,
+            .spi_host = SPI2_HOST,
+        },
+    };
+    CHECK_ERR(ESP_OK, pn532_init(&handle, &config));
+
+    RUN(test_largest_extended_frame);
+    RUN(test_too_long_rejected);
+
+    CHECK_ERR(ESP_OK, pn532_free(handle));
+    fake_spi_attach(NULL);
+    return 0;
+}
@@ -0,0 +1,75 @@
+// UART frame reads into a buffer smaller than the frame, as the ack wait does with ACK_OFFSET bytes
+
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <string.h>
+
+#include "fake_hw.h"
+#include "test_host.h"
+
+#define UART_PORT 1
+#define ACK_SIZE 6
+#define CANARY 0xA5
+
+static pn532_handle_t handle;
+
+static void read_into_ack_slot(const uint8_t* wire, size_t wire_len, esp_err_t expected) {
+    uint8_t frame[16];
+    memset(frame, CANARY, sizeof(frame));
+    fake_uart_inject(UART_PORT, wire, wire_len);
+
+    size_t frame_len = 0;
+    CHECK_ERR(expected, handle->read_frame(handle, frame, ACK_SIZE, &frame_len, pdMS_TO_TICKS(100)));
+    for(size_t i = ACK_SIZE; i < sizeof(frame); i++) {
+        CHECK(frame[i] == CANARY);
+    }
+}
+
+static void test_ack_fits(void) {
+    static const uint8_t ack[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+    read_into_ack_slot(ack, sizeof(ack), ESP_OK);
+}
+
+static void test_normal_frame_too_long(void) {
+    // GetFirmwareVersion response where the ack was expected
+    static const uint8_t frame[] = {0x00, 0x00, 0xFF, 0x06, 0xFA, 0xD5, 0x03, 0x32, 0x01, 0x06, 0x07, 0xE8, 0x00};
+    read_into_ack_slot(frame, sizeof(frame), ESP_ERR_INVALID_SIZE);
+}
+
+static void test_extended_frame_too_long(void) {
+    // the extended header alone is longer than the ack slot
+    static const uint8_t frame[] = {0x00, 0x00, 0xFF, 0xFF, 0xFF, 0x00, 0x02, 0xFE, 0xD5, 0x03, 0x28, 0x00};
+    read_into_ack_slot(frame, sizeof(frame), ESP_ERR_INVALID_SIZE);
+}
+
+static void test_skipped_frame_leaves_next(void) {
+    // the rejected frame is skipped on the wire, the ack behind it still reads
+    static const uint8_t frames[] = {
+        0x00, 0x00, 0xFF, 0xFF, 0xFF, 0x00, 0x02, 0xFE, 0xD5, 0x03, 0x28, 0x00,
+        0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00,
+    };
+    read_into_ack_slot(frames, sizeof(frames), ESP_ERR_INVALID_SIZE);
+    read_into_ack_slot(NULL, 0, ESP_OK);
+}
+
+int main(void) {
+    const pn532_config_t config = {
+        .protocol = PN532_UART_PROTOCOL,
+        .uart = {
+            .tx = 17,
+            .rx = 16,
+            .uart_port = UART_PORT,
+            .baud_rate = 115200,
+        },
+    };
+    CHECK_ERR(ESP_OK, pn532_init(&handle, &config));
+
+    RUN(test_ack_fits);
+    RUN(test_normal_frame_too_long);
+    RUN(test_extended_frame_too_long);
+    RUN(test_skipped_frame_leaves_next);
+
+    CHECK_ERR(ESP_OK, pn532_free(handle));
+    return 0;
+}
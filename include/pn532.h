@@ -2,8 +2,13 @@
 
 #include <esp_err.h>
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
 #include <driver/gpio.h>
 #include <driver/uart.h>
+#include <driver/i2c_master.h>
+#include <driver/spi_master.h>
 
 #define PN532_PREAMBLE 0x00
 #define PN532_STARTCODE1 0x00
@@ -47,6 +52,80 @@
 
 #define PN532_MIFARE_ISO14443A 0x00
 
+#ifdef CONFIG_PN532_BUFFER_SIZE
+    #define PN532_DEFAULT_BUFFER_SIZE CONFIG_PN532_BUFFER_SIZE
+#else
+    #define PN532_DEFAULT_BUFFER_SIZE 256
+#endif
+#define PN532_I2C_ADDRESS 0x24 // 7 bit
+#define PN532_I2C_DEFAULT_CLK_SPEED 100000
+#define PN532_SPI_DEFAULT_CLK_SPEED 1000000
+#define PN532_SPI_MAX_CLK_SPEED 5000000
+
+// PowerDown wake-up sources
+#define PN532_WAKEUP_INT0 0x01
+#define PN532_WAKEUP_INT1 0x02
+#define PN532_WAKEUP_RF 0x08 // external RF field (a phone or another reader), not a passive card
+#define PN532_WAKEUP_HSU 0x10
+#define PN532_WAKEUP_SPI 0x20
+#define PN532_WAKEUP_GPIO 0x40
+#define PN532_WAKEUP_I2C 0x80
+
+#define PN532_MIN_BUFFER_SIZE 64
+#define PN532_MAX_FRAME_DATA 265 // extended frame LEN, TFI included
+#define PN532_EXTENDED_BUFFER_SIZE (6 + 8 + PN532_MAX_FRAME_DATA + 2 + 1) // ack + largest extended frame + i2c status byte
+
+#define PN532_ASYNC_MAX_COMMAND_LEN 64
+
+#define PN532_MAX_TARGETS 2
+#define PN532_MAX_UID_LEN 10
+#define PN532_MAX_ATS_LEN 32
+
+#define PN532_NTAG_VERSION_LEN 8
+#define PN532_NTAG_MAX_USER_MEMORY 888 // NTAG216
+
+#ifdef CONFIG_PN532_STATS_MAX_COMMANDS
+    #define PN532_STATS_MAX_COMMANDS CONFIG_PN532_STATS_MAX_COMMANDS
+#else
+    #define PN532_STATS_MAX_COMMANDS 12
+#endif
+#define PN532_STATS_OTHER 0xFF // command code of the shared slot
+#define PN532_STATS_HIST_BUCKETS 12
+#define PN532_STATS_HIST_BASE_US 128 // bucket 0 < 128us, bucket n < 128us << n, last bucket is open
+
+#define PN532_AUTOPOLL_MAX_TYPES 15
+
+// InAutoPoll target types
+#define PN532_AUTOPOLL_GENERIC_106A 0x00
+#define PN532_AUTOPOLL_MIFARE 0x10
+#define PN532_AUTOPOLL_ISO14443_4A 0x20
+
+#define PN532_TARGET_MAX_COMMAND 512 // chained initiator command
+#define PN532_TARGET_MAX_RESPONSE 253 // TgSetData, a single normal frame
+
+// TgInitAsTarget modes
+#define PN532_TARGET_MODE_PASSIVE_ONLY 0x01
+#define PN532_TARGET_MODE_DEP_ONLY 0x02
+#define PN532_TARGET_MODE_PICC_ONLY 0x04
+
+// InJumpForDEP baud rates
+#define PN532_DEP_106 0x00
+#define PN532_DEP_212 0x01
+#define PN532_DEP_424 0x02
+
+#define PN532_DEP_MAX_CHUNK 262 // InDataExchange DataOut, larger messages are chained with MI
+
+#define PN532_CIU_BASE 0x6301 // first CIU register (CIU_Mode), the shadow cache covers PN532_CIU_BASE to PN532_CIU_BASE + PN532_CIU_SIZE - 1
+#define PN532_CIU_SIZE 0x3F
+
+#ifdef CONFIG_PN532_UID_CACHE_SIZE
+    #define PN532_UID_CACHE_SIZE CONFIG_PN532_UID_CACHE_SIZE
+#else
+    #define PN532_UID_CACHE_SIZE 16
+#endif
+
+#define PN532_GROUP_MAX_READERS 4
+
 /**
  * @brief PN532 protocol type
  * 
@@ -63,6 +142,366 @@ typedef enum {
  * 
  */
 typedef struct pn532_t* pn532_handle_t;
+typedef struct pn532_group_t* pn532_group_handle_t;
+
+/**
+ * @brief PN532 command latency
+ * 
+ */
+typedef struct {
+    uint32_t ack_latency_us; // time from frame written to ACK received
+    uint32_t response_latency_us; // time from ACK received to response received
+} pn532_latency_t;
+
+/**
+ * @brief PN532 target mode handler
+ * 
+ * Runs in the task that called pn532_target_run(), or in the async worker task in async mode, with the
+ * handle locked: calling any pn532 function from it deadlocks (in async mode the worker waits on itself).
+ * The reader is waiting meanwhile, so it should return quickly.
+ * 
+ */
+typedef esp_err_t (*pn532_target_handler_t)(const uint8_t* command, size_t command_len, uint8_t* response, size_t* response_len, void* arg);
+
+/**
+ * @brief PN532 target mode configuration
+ * 
+ */
+typedef struct {
+    uint8_t mode; // PN532_TARGET_MODE_* flags, 0 accepts any activation
+    uint8_t mifare_params[6]; // SENS_RES (2), NFCID1t (3), SEL_RES (1)
+    uint8_t felica_params[18]; // NFCID2t (8), PAD (8), system code (2)
+    uint8_t nfcid3t[10];
+    const uint8_t* general_bytes; // ATR_RES general bytes (up to 47)
+    uint8_t general_bytes_len;
+    const uint8_t* historical_bytes; // ATS historical bytes (up to 30)
+    uint8_t historical_bytes_len;
+    uint32_t activation_timeout; // ms to wait for an initiator
+    uint32_t exchange_timeout; // ms to wait for the next initiator command before the session ends
+    pn532_target_handler_t handler; // response_len holds the response capacity on entry
+    void* arg;
+} pn532_target_config_t;
+
+/**
+ * @brief PN532 target mode session stats
+ * 
+ */
+typedef struct {
+    uint8_t mode; // activated mode reported by TgInitAsTarget (baud rate, DEP, PICC)
+    uint32_t exchanges;
+    uint32_t bytes_in;
+    uint32_t bytes_out;
+    uint32_t last_turnaround_us; // initiator command received to response accepted by the PN532
+    uint32_t max_turnaround_us;
+    uint64_t total_turnaround_us;
+    uint64_t handler_us; // part of the turnaround spent in the handler
+} pn532_target_stats_t;
+
+/**
+ * @brief PN532 DEP initiator configuration
+ * 
+ */
+typedef struct {
+    uint8_t baud_rate; // PN532_DEP_106, PN532_DEP_212 or PN532_DEP_424
+    bool active; // active mode, otherwise passive (the target is powered by the field)
+    const uint8_t* general_bytes; // ATR_REQ general bytes Gi (up to 48, e.g. LLCP parameters)
+    uint8_t general_bytes_len;
+    uint32_t timeout; // ms to wait for each InDataExchange response (0 for default)
+} pn532_dep_config_t;
+
+/**
+ * @brief PN532 DEP transfer stats
+ * 
+ */
+typedef struct {
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    uint32_t chunks; // InDataExchange round-trips
+    uint64_t transfer_us; // time spent in exchanges
+    uint32_t bytes_per_second; // sent and received, over transfer_us
+} pn532_dep_stats_t;
+
+/**
+ * @brief PN532 DEP initiator session
+ * 
+ */
+typedef struct {
+    pn532_handle_t pn532; // NULL once closed
+    uint8_t tg;
+    uint8_t nfcid3t[10];
+    uint8_t general_bytes[48]; // ATR_RES general bytes Gt
+    uint8_t general_bytes_len;
+    uint32_t timeout;
+    pn532_dep_stats_t stats;
+} pn532_dep_session_t;
+
+/**
+ * @brief PN532 register write
+ * 
+ */
+typedef struct {
+    uint16_t address; // CIU (0x63xx) or SFR (0xFFxx) address
+    uint8_t value;
+} pn532_register_t;
+
+// RFConfiguration timeout codes (item 0x02), 100us * 2^(n-1)
+#define PN532_RF_TIMEOUT_NONE 0x00
+#define PN532_RF_TIMEOUT_100US 0x01
+#define PN532_RF_TIMEOUT_400US 0x03
+#define PN532_RF_TIMEOUT_1_6MS 0x05
+#define PN532_RF_TIMEOUT_6_4MS 0x07
+#define PN532_RF_TIMEOUT_25_6MS 0x09
+#define PN532_RF_TIMEOUT_51_2MS 0x0A
+#define PN532_RF_TIMEOUT_102_4MS 0x0B
+#define PN532_RF_TIMEOUT_204_8MS 0x0C
+#define PN532_RF_TIMEOUT_409_6MS 0x0D
+#define PN532_RF_TIMEOUT_3_28S 0x10
+
+/**
+ * @brief PN532 RF profile
+ * 
+ * RFConfiguration items 0x01, 0x02, 0x04 and 0x05.
+ * 
+ */
+typedef struct {
+    bool rf_field; // item 0x01, field on (otherwise switched on only while a command needs it)
+    bool auto_rfca; // item 0x01, RF collision avoidance before switching the field on
+    uint8_t atr_res_timeout; // item 0x02, PN532_RF_TIMEOUT_* for ATR_RES (DEP)
+    uint8_t retry_timeout; // item 0x02, PN532_RF_TIMEOUT_* for InCommunicateThru and non-DEP exchanges
+    uint8_t max_retry_com; // item 0x04, InDataExchange/InCommunicateThru retries on timeout
+    uint8_t max_retry_atr; // item 0x05, ATR_REQ retries
+    uint8_t max_retry_psl; // item 0x05, PSL_REQ and PSL_RES retries
+    uint8_t max_retry_passive_activation; // item 0x05, 0x00 is a single try, 0xFF retries forever
+} pn532_rf_profile_t;
+
+// datasheet defaults, waits forever for a target
+#define PN532_RF_PROFILE_DEFAULT() { \
+    .rf_field = true, \
+    .auto_rfca = true, \
+    .atr_res_timeout = PN532_RF_TIMEOUT_102_4MS, \
+    .retry_timeout = PN532_RF_TIMEOUT_51_2MS, \
+    .max_retry_com = 0x00, \
+    .max_retry_atr = 0xFF, \
+    .max_retry_psl = 0x01, \
+    .max_retry_passive_activation = 0xFF, \
+}
+
+// an empty field answers after a single activation attempt, short timeouts for the exchanges that follow
+#define PN532_RF_PROFILE_FAST_POLL() { \
+    .rf_field = true, \
+    .auto_rfca = true, \
+    .atr_res_timeout = PN532_RF_TIMEOUT_25_6MS, \
+    .retry_timeout = PN532_RF_TIMEOUT_6_4MS, \
+    .max_retry_com = 0x00, \
+    .max_retry_atr = 0x01, \
+    .max_retry_psl = 0x01, \
+    .max_retry_passive_activation = 0x00, \
+}
+
+// weak coupling at the edge of the field: more attempts and longer timeouts
+#define PN532_RF_PROFILE_LONG_RANGE() { \
+    .rf_field = true, \
+    .auto_rfca = true, \
+    .atr_res_timeout = PN532_RF_TIMEOUT_204_8MS, \
+    .retry_timeout = PN532_RF_TIMEOUT_102_4MS, \
+    .max_retry_com = 0x03, \
+    .max_retry_atr = 0xFF, \
+    .max_retry_psl = 0x03, \
+    .max_retry_passive_activation = 0x10, \
+}
+
+// field only on during commands, a single short attempt per poll
+#define PN532_RF_PROFILE_LOW_POWER() { \
+    .rf_field = false, \
+    .auto_rfca = true, \
+    .atr_res_timeout = PN532_RF_TIMEOUT_25_6MS, \
+    .retry_timeout = PN532_RF_TIMEOUT_6_4MS, \
+    .max_retry_com = 0x00, \
+    .max_retry_atr = 0x01, \
+    .max_retry_psl = 0x01, \
+    .max_retry_passive_activation = 0x00, \
+}
+
+/**
+ * @brief PN532 bring-up configuration
+ * 
+ */
+typedef struct {
+    uint8_t passive_activation_retries; // 0x00 is a single try, 0xFF retries forever
+} pn532_bring_up_config_t;
+
+/**
+ * @brief PN532 bring-up report
+ * 
+ */
+typedef struct {
+    uint8_t version[4]; // IC, firmware version, firmware revision, support
+    uint32_t wake_us; // transport wake-up sequence
+    uint32_t link_us; // GetFirmwareVersion round-trip, including a retry
+    uint32_t sam_us; // SAMConfiguration round-trip
+    uint32_t rf_us; // RFConfiguration round-trip
+    uint32_t total_us;
+} pn532_bring_up_report_t;
+
+/**
+ * @brief PN532 request priority
+ * 
+ */
+typedef enum {
+    PN532_PRIORITY_NORMAL,
+    PN532_PRIORITY_HIGH, // served before any queued normal request
+    PN532_PRIORITY_MAX,
+} pn532_priority_t;
+
+/**
+ * @brief PN532 command completion callback
+ * 
+ * Runs in the worker task. The response frame is only valid during the call.
+ * 
+ */
+typedef void (*pn532_command_cb_t)(pn532_handle_t pn532_handle, esp_err_t err, const uint8_t* response, size_t response_len, void* arg);
+
+/**
+ * @brief PN532 async mode configuration
+ * 
+ */
+typedef struct {
+    bool enabled; // start a worker task that owns the transport
+    uint32_t task_stack_size; // worker stack size (0 for default)
+    UBaseType_t task_priority; // worker priority (0 for default)
+    BaseType_t task_core; // worker core or tskNO_AFFINITY (only used if task_pinned is set)
+    bool task_pinned; // pin the worker to task_core
+    size_t queue_len; // requests per priority queue (0 for default)
+} pn532_async_config_t;
+
+/**
+ * @brief PN532 passive target (ISO14443A)
+ * 
+ */
+typedef struct {
+    uint8_t tg; // logical target number
+    uint16_t atqa; // SENS_RES
+    uint8_t sak; // SEL_RES
+    uint8_t uid[PN532_MAX_UID_LEN];
+    uint8_t uid_len;
+    uint8_t ats[PN532_MAX_ATS_LEN]; // ATS including its length byte, truncated to PN532_MAX_ATS_LEN
+    uint8_t ats_len; // 0 if the target is not ISO14443-4 compliant
+} pn532_target_t;
+
+/**
+ * @brief PN532 scan event kind
+ * 
+ */
+typedef enum {
+    PN532_SCAN_DETECTED, // every detection (dedup_ttl_ms = 0)
+    PN532_SCAN_ARRIVED, // first detection of a UID
+    PN532_SCAN_DEPARTED, // UID not seen for dedup_ttl_ms, only type, uid and sak are set
+} pn532_scan_event_kind_t;
+
+/**
+ * @brief PN532 scan event
+ * 
+ */
+typedef struct {
+    pn532_scan_event_kind_t kind;
+    uint8_t type; // autopoll target type (PN532_AUTOPOLL_*)
+    uint8_t reader; // reader index in its group (0 outside a group)
+    pn532_target_t target;
+    int64_t timestamp_us; // esp_timer time the target was reported
+} pn532_scan_event_t;
+
+/**
+ * @brief PN532 autopoll configuration
+ * 
+ */
+typedef struct {
+    uint8_t types[PN532_AUTOPOLL_MAX_TYPES]; // target types to poll (PN532_AUTOPOLL_*)
+    size_t num_types;
+    uint8_t poll_count; // polls per type in each InAutoPoll (0x01 ~ 0xFE, 0xFF endless)
+    uint8_t period; // time between polls in units of 150ms (0x01 ~ 0x0F)
+    size_t queue_len; // event queue length (0 for default)
+    uint32_t task_stack_size; // scan task stack size (0 for default)
+    UBaseType_t task_priority; // scan task priority (0 for default)
+    BaseType_t task_core; // scan task core or tskNO_AFFINITY (only used if task_pinned is set)
+    bool task_pinned; // pin the scan task to task_core
+    uint32_t dedup_ttl_ms; // report a UID on arrival and once unseen for this long (0 reports every detection)
+} pn532_autopoll_config_t;
+
+/**
+ * @brief MIFARE Classic key type
+ * 
+ */
+typedef enum {
+    PN532_MIFARE_KEY_A = 0x60,
+    PN532_MIFARE_KEY_B = 0x61,
+} pn532_mifare_key_type_t;
+
+/**
+ * @brief MIFARE Classic sector and its key
+ * 
+ */
+typedef struct {
+    uint8_t sector; // 0 ~ 15 (1K), 0 ~ 39 (4K)
+    pn532_mifare_key_type_t key_type;
+    uint8_t key[6];
+} pn532_mifare_sector_t;
+
+/**
+ * @brief PN532 per-command statistics
+ * 
+ * Latency sums are in microseconds, divide by count/responses for the mean.
+ * 
+ */
+typedef struct {
+    uint8_t command; // PN532_COMMAND_* or PN532_STATS_OTHER
+    uint32_t count; // commands written
+    uint32_t responses; // responses received
+    uint32_t timeouts;
+    uint32_t bad_acks;
+    uint32_t checksum_errors;
+    uint32_t retries;
+    uint32_t errors; // any other failure
+    uint64_t bytes_out;
+    uint64_t bytes_in;
+    uint64_t write_time_us;
+    uint64_t ack_latency_us;
+    uint64_t response_latency_us;
+    uint32_t ack_hist[PN532_STATS_HIST_BUCKETS];
+    uint32_t response_hist[PN532_STATS_HIST_BUCKETS];
+} pn532_command_stats_t;
+
+/**
+ * @brief PN532 statistics snapshot
+ * 
+ */
+typedef struct {
+    pn532_command_stats_t commands[PN532_STATS_MAX_COMMANDS];
+    size_t num_commands;
+} pn532_stats_t;
+
+/**
+ * @brief PN532 low-power scan configuration
+ * 
+ */
+typedef struct {
+    uint32_t sleep_ms; // time powered down between scans (host timer)
+    uint8_t wake_sources; // extra PN532_WAKEUP_* sources, the transport's own source is always set
+    uint8_t scan_retries; // passive activation retries of each scan (0x00 ~ 0xFE), each one adds up to 10ms to a scan
+} pn532_lowpower_config_t;
+
+/**
+ * @brief PN532 low-power statistics
+ * 
+ * Times are totals in microseconds since the handle was created.
+ * 
+ */
+typedef struct {
+    uint32_t cycles; // power down / wake up cycles
+    uint64_t sleep_us; // powered down
+    uint64_t wake_us; // wake-up sequence until the PN532 accepted a command
+    uint64_t scan_us; // scanning for targets
+    uint32_t last_wake_to_uid_us; // wake-up to UID of the last detection
+} pn532_lowpower_stats_t;
 
 /**
  * @brief PN532 uart configuration
@@ -73,6 +512,8 @@ typedef struct {
     gpio_num_t rx; // UART RX pin
     uart_port_t uart_port; // UART port number. UART_NUM_0 ~ (UART_NUM_MAX - 1)
     uint32_t baud_rate; // UART baud rate
+    gpio_num_t irq; // PN532 IRQ pin, only used if use_irq is set
+    bool use_irq; // wait for the IRQ pin before reading responses
 } pn532_uart_config_t;
 
 /**
@@ -80,7 +521,13 @@ typedef struct {
  * 
  */
 typedef struct {
-    // todo 
+    gpio_num_t sda; // I2C SDA pin, not used if bus is set
+    gpio_num_t scl; // I2C SCL pin, not used if bus is set
+    i2c_port_num_t i2c_port; // I2C port number, not used if bus is set
+    uint32_t clk_speed; // I2C clock in Hz, up to 400kHz (0 for PN532_I2C_DEFAULT_CLK_SPEED)
+    i2c_master_bus_handle_t bus; // bus shared with other devices (NULL to create one on sda/scl)
+    gpio_num_t irq; // PN532 IRQ pin, only used if use_irq is set
+    bool use_irq; // wait for the IRQ pin instead of polling the status byte
 } pn532_i2c_config_t;
 
 /**
@@ -88,7 +535,15 @@ typedef struct {
  * 
  */
 typedef struct {
-    // todo
+    gpio_num_t miso; // SPI MISO pin, not used if bus_initialized is set
+    gpio_num_t mosi; // SPI MOSI pin, not used if bus_initialized is set
+    gpio_num_t sclk; // SPI SCLK pin, not used if bus_initialized is set
+    gpio_num_t cs; // SPI CS (SS) pin
+    spi_host_device_t spi_host; // SPI host, e.g. SPI2_HOST
+    uint32_t clk_speed; // SPI clock in Hz, up to PN532_SPI_MAX_CLK_SPEED (0 for PN532_SPI_DEFAULT_CLK_SPEED)
+    bool bus_initialized; // bus already initialized by the application (with DMA) and shared with other devices
+    gpio_num_t irq; // PN532 IRQ pin, only used if use_irq is set
+    bool use_irq; // wait for the IRQ pin instead of polling the status byte
 } pn532_spi_config_t;
 
 /**
@@ -102,13 +557,47 @@ typedef struct {
         pn532_i2c_config_t i2c;
         pn532_spi_config_t spi;
     };
+    pn532_async_config_t async;
+    size_t buffer_size; // receive buffer size (0 for PN532_DEFAULT_BUFFER_SIZE, PN532_EXTENDED_BUFFER_SIZE fits any frame)
 } pn532_config_t;
 
+/**
+ * @brief PN532 reader group member configuration
+ * 
+ */
+typedef struct {
+    pn532_config_t config;
+    BaseType_t task_core; // scan task core or tskNO_AFFINITY (only used if task_pinned is set)
+    bool task_pinned; // pin the scan task to task_core
+} pn532_group_reader_config_t;
+
+/**
+ * @brief PN532 reader group configuration
+ * 
+ */
+typedef struct {
+    pn532_group_reader_config_t readers[PN532_GROUP_MAX_READERS];
+    size_t num_readers;
+    pn532_autopoll_config_t autopoll; // scan run by every reader, queue_len is per reader and task_core/task_pinned come from the reader
+} pn532_group_config_t;
+
+/**
+ * @brief PN532 reader group statistics
+ * 
+ */
+typedef struct {
+    pn532_stats_t commands; // command statistics summed over all readers
+    uint32_t events[PN532_GROUP_MAX_READERS]; // events posted by each reader
+    uint32_t dropped[PN532_GROUP_MAX_READERS]; // events each reader lost to a full queue
+    size_t num_readers;
+} pn532_group_stats_t;
+
 /**
  * @brief Initialize PN532 device.
  * 
  * Sets up the PN532 device with the given configuration.
- * (UART, I2C, or SPI) ** Only UART is implemented **
+ * (UART, I2C, or SPI)
+ * If async mode is enabled, a worker task is started and every command runs on it.
  * 
  * @param[out] pn532_handle Pointer to the PN532 handle.
  * @param[in] config Configuration settings for the PN532 device.
@@ -121,10 +610,31 @@ typedef struct {
  */
 esp_err_t pn532_init(pn532_handle_t* pn532_handle, const pn532_config_t* config);
 
+/**
+ * @brief Initialize PN532 device in caller provided storage.
+ * 
+ * Same as pn532_init(), but the handle, its buffer and its mutex live in storage, so the handle
+ * itself takes nothing from the heap. Declare the storage with pn532_static_t (pn532_types.h),
+ * its buffer is PN532_DEFAULT_BUFFER_SIZE (CONFIG_PN532_BUFFER_SIZE).
+ * Transport drivers and the async worker still allocate their own resources.
+ * The storage must outlive the handle, pn532_free() releases everything but the storage.
+ * 
+ * @param[out] pn532_handle Pointer to the PN532 handle.
+ * @param[in] config Configuration settings for the PN532 device, buffer_size must be 0 or fit the storage.
+ * @param[in] storage Storage for the handle, PN532_STATIC_HANDLE_SIZE bytes.
+ * 
+ * @return 
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if the configuration is invalid.
+ *  - Other error codes from the protocol-specific initialization functions.
+ */
+esp_err_t pn532_init_static(pn532_handle_t* pn532_handle, const pn532_config_t* config, void* storage);
+
 /**
  * @brief Free PN532 device.
  * 
  * Frees the resources used by the PN532 device.
+ * In async mode, requests still queued fail with ESP_ERR_INVALID_STATE.
  * 
  * @param[in] pn532_handle PN532 handle.
  * 
@@ -149,6 +659,27 @@ esp_err_t pn532_free(pn532_handle_t pn532_handle);
  */
 esp_err_t pn532_start(pn532_handle_t pn532_handle);
 
+/**
+ * @brief Bring up PN532 device.
+ * 
+ * Replaces pn532_start(), pn532_get_firmware_version(), pn532_SAM_configuration() and
+ * pn532_set_passive_activation_retries() with one request: wakes the PN532 up (the HSU 0x55 preamble on UART),
+ * checks the link with GetFirmwareVersion and configures SAM and RF back-to-back, without fixed sleeps.
+ * Safe to call again to recover a PN532 that lost power.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[in] config Bring-up configuration.
+ * @param[out] report Firmware version and time spent in each step (can be NULL).
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle or config is invalid.
+ * - ESP_ERR_INVALID_RESPONSE if a response check failed.
+ * - ESP_ERR_TIMEOUT if the PN532 did not answer in time.
+ * - Other error codes from write and read functions.
+ */
+esp_err_t pn532_bring_up(pn532_handle_t pn532_handle, const pn532_bring_up_config_t* config, pn532_bring_up_report_t* report);
+
 /**
  * @brief Send command to PN532 and check acknowledgment.
  * 
@@ -165,7 +696,76 @@ esp_err_t pn532_start(pn532_handle_t pn532_handle);
  * - ESP_ERR_INVALID_RESPONSE if the acknowledgment is invalid.
  * - Other error codes from write and read functions.
  */
-esp_err_t pn532_send_command_check_ack(pn532_handle_t pn532_handle, uint8_t* command, uint8_t command_len, uint32_t timeout);
+esp_err_t pn532_send_command_check_ack(pn532_handle_t pn532_handle, uint8_t* command, size_t command_len, uint32_t timeout);
+
+/**
+ * @brief Send command to PN532 and measure ACK and response latency.
+ * 
+ * Writes a command, waits for the ACK frame and then for the response frame.
+ * Each phase has its own deadline, there are no fixed delays.
+ * Commands longer than 254 bytes are sent as extended frames.
+ * The ACK is stored at the start of the handle buffer and the response right after it.
+ * In async mode the handle buffer belongs to the worker and may already hold the next request's
+ * frames when this returns, use pn532_submit_command() to get the response.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[in] command Pointer to the command buffer.
+ * @param[in] command_len Length of the command buffer.
+ * @param[in] ack_timeout ACK timeout in milliseconds.
+ * @param[in] response_timeout Response timeout in milliseconds.
+ * @param[out] latency Pointer to the latency report (can be NULL).
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle or command is invalid.
+ * - ESP_ERR_INVALID_RESPONSE if the acknowledgment is invalid.
+ * - ESP_ERR_TIMEOUT if the PN532 did not answer in time.
+ * - Other error codes from write and read functions.
+ */
+esp_err_t pn532_send_command_timed(pn532_handle_t pn532_handle, uint8_t* command, size_t command_len, uint32_t ack_timeout, uint32_t response_timeout, pn532_latency_t* latency);
+
+/**
+ * @brief Submit command to the async worker.
+ * 
+ * Queues a command without blocking. The command is copied, the callback runs on the worker
+ * task once the response arrived or the command failed. High priority requests are served
+ * before any queued normal request. Requests still queued when the handle is freed complete
+ * with ESP_ERR_INVALID_STATE.
+ * 
+ * @param[in] pn532_handle PN532 handle (async mode must be enabled).
+ * @param[in] command Pointer to the command buffer.
+ * @param[in] command_len Length of the command buffer (up to PN532_ASYNC_MAX_COMMAND_LEN).
+ * @param[in] timeout Response timeout in milliseconds.
+ * @param[in] priority Request priority.
+ * @param[in] callback Completion callback (can be NULL).
+ * @param[in] arg User argument passed to the callback.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle or command is invalid.
+ * - ESP_ERR_INVALID_STATE if async mode is disabled or the handle is being freed.
+ * - ESP_ERR_NO_MEM if the queue is full.
+ */
+esp_err_t pn532_submit_command(pn532_handle_t pn532_handle, const uint8_t* command, size_t command_len, uint32_t timeout, pn532_priority_t priority, pn532_command_cb_t callback, void* arg);
+
+/**
+ * @brief Change PN532 serial baud rate.
+ * 
+ * Negotiates a new HSU baud rate with SetSerialBaudRate, acknowledges the response,
+ * switches the host UART and verifies the link with a firmware version round-trip.
+ * If the verification fails, the previous baud rate is restored.
+ * The whole sequence runs under the handle mutex. Only available for UART.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[in] baud_rate New baud rate (9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600 or 1288000).
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle or baud rate is invalid.
+ * - ESP_ERR_NOT_SUPPORTED if the protocol is not UART.
+ * - ESP_ERR_INVALID_RESPONSE if the command failed or the link check failed (previous baud rate restored).
+ */
+esp_err_t pn532_set_serial_baud_rate(pn532_handle_t pn532_handle, uint32_t baud_rate);
 
 /**
  * @brief Get PN532 firmware version.
@@ -211,24 +811,294 @@ esp_err_t pn532_SAM_configuration(pn532_handle_t pn532_handle);
  */
 esp_err_t pn532_set_passive_activation_retries(pn532_handle_t pn532_handle, uint8_t max_retries);
 
+/**
+ * @brief Apply an RF profile.
+ * 
+ * Sends RFConfiguration items 0x02, 0x04, 0x05 and 0x01 back-to-back in a single request.
+ * Start from one of the PN532_RF_PROFILE_* presets and adjust fields as needed.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[in] profile RF profile.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle or profile is invalid.
+ * - ESP_ERR_INVALID_RESPONSE if a response check failed.
+ * - Other error codes from write and read functions.
+ */
+esp_err_t pn532_set_rf_profile(pn532_handle_t pn532_handle, const pn532_rf_profile_t* profile);
+
 /**
  * @brief Read UID of passive target.
  * 
  * Detects a passive target and reads its UID
+ * Only ISO14443A (106 kbps type A) targets have their UID parsed, other baud rates are rejected
+ * instead of being sent to the PN532.
  * 
  * @param[in] pn532_handle PN532 handle.
- * @param[in] card_baud_rate Baud rate of the card (e.g., ISO14443A).
+ * @param[in] card_baud_rate Baud rate of the card, must be PN532_MIFARE_ISO14443A.
  * @param[out] uid Buffer to store the UID.
  * @param[out] uid_len Pointer to the UID length.
  * 
  * @return
  * - ESP_OK on success.
  * - ESP_ERR_INVALID_ARG if the handle or UID buffer is invalid.
+ * - ESP_ERR_NOT_SUPPORTED if card_baud_rate is not PN532_MIFARE_ISO14443A.
  * - ESP_ERR_INVALID_RESPONSE if target detection or acknowledgment failed.
  * - ESP_ERR_NOT_FOUND if no target was found.
  */
 esp_err_t pn532_read_passive_target_id(pn532_handle_t pn532_handle, uint8_t card_baud_rate, uint8_t* uid, size_t* uid_len);
 
+/**
+ * @brief List passive targets.
+ * 
+ * Detects up to max_targets targets in a single InListPassiveTarget exchange and
+ * returns their descriptors (Tg, ATQA, SAK, UID and ATS when present).
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[in] card_baud_rate Baud rate of the card (only ISO14443A is supported).
+ * @param[in] max_targets Maximum number of targets (1 ~ PN532_MAX_TARGETS).
+ * @param[out] targets Buffer to store the targets (must have atleast max_targets entries).
+ * @param[out] num_targets Pointer to the number of targets found.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle, buffers or max_targets are invalid.
+ * - ESP_ERR_NOT_SUPPORTED if the card baud rate is not supported.
+ * - ESP_ERR_INVALID_RESPONSE if target detection or acknowledgment failed.
+ * - ESP_ERR_NOT_FOUND if no target was found.
+ */
+esp_err_t pn532_list_passive_targets(pn532_handle_t pn532_handle, uint8_t card_baud_rate, uint8_t max_targets, pn532_target_t* targets, size_t* num_targets);
+
+/**
+ * @brief Check whether a listed target is still in the field.
+ * 
+ * Uses the smallest exchange the target type allows, instead of a new anticollision:
+ * ISO14443-4 targets get an attention request (Diagnose 0x06), Ultralight/NTAG a read of page 0,
+ * MIFARE Classic an InDeselect/InSelect pair (which drops an authenticated sector).
+ * A target that is still there stays selected for further commands.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[in] target Target returned by pn532_list_passive_targets() or autopoll.
+ * @param[out] present true if the target answered, false if it is gone.
+ * 
+ * @return
+ * - ESP_OK on success (present or not).
+ * - ESP_ERR_INVALID_ARG if the handle, target or present is invalid.
+ * - ESP_ERR_TIMEOUT if the PN532 did not respond.
+ * - Other errors from the transport.
+ */
+esp_err_t pn532_target_present(pn532_handle_t pn532_handle, const pn532_target_t* target, bool* present);
+
+/**
+ * @brief Run one target mode session.
+ * 
+ * Emulates a tag or DEP target: waits for an initiator with TgInitAsTarget, then passes every
+ * initiator command (chained parts joined) to the handler and sends its response back with TgSetData,
+ * until the initiator releases the target, switches its field off or stays silent for exchange_timeout.
+ * The handle is locked for the whole session. Buffers are allocated once per session, never per exchange.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[in] config Target configuration.
+ * @param[out] stats Session stats, including turnaround latency.
+ * 
+ * @return
+ * - ESP_OK once the session ended.
+ * - ESP_ERR_INVALID_ARG if an argument is invalid.
+ * - ESP_ERR_TIMEOUT if no initiator activated the target within activation_timeout.
+ * - ESP_ERR_INVALID_STATE if the PN532 reported a target error.
+ * - Other error codes from the handler, write and read functions.
+ */
+esp_err_t pn532_target_run(pn532_handle_t pn532_handle, const pn532_target_config_t* config, pn532_target_stats_t* stats);
+
+/**
+ * @brief Open a DEP initiator session.
+ * 
+ * Activates a DEP target (a phone or another PN532 in target mode) with InJumpForDEP.
+ * Full-size chunks need a handle created with buffer_size PN532_EXTENDED_BUFFER_SIZE.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[in] config DEP configuration.
+ * @param[out] session Session state, owned by the caller.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if an argument is invalid.
+ * - ESP_ERR_NOT_FOUND if no DEP target answered.
+ * - Other error codes from write and read functions.
+ */
+esp_err_t pn532_dep_open(pn532_handle_t pn532_handle, const pn532_dep_config_t* config, pn532_dep_session_t* session);
+
+/**
+ * @brief Exchange one message with the DEP target.
+ * 
+ * Sends tx split into PN532_DEP_MAX_CHUNK chunks chained with the MI bit, then collects the target's reply,
+ * fetching the chained parts as well, all in a single request. Chunks are sent from tx without a copy,
+ * and each received part is copied into rx while the PN532 fetches the next one.
+ * 
+ * @param[in] session Open DEP session.
+ * @param[in] tx Message to send (can be NULL when tx_len is 0, an empty message polls the target).
+ * @param[in] tx_len Length of the message.
+ * @param[out] rx Reply buffer (can be NULL when rx_size is 0, the reply is discarded).
+ * @param[in] rx_size Size of the reply buffer.
+ * @param[out] rx_len Length of the reply (can be NULL).
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if an argument is invalid.
+ * - ESP_ERR_INVALID_SIZE if the reply does not fit rx.
+ * - ESP_ERR_INVALID_STATE if the PN532 reported a DEP error.
+ * - Other error codes from write and read functions.
+ */
+esp_err_t pn532_dep_transceive(pn532_dep_session_t* session, const uint8_t* tx, size_t tx_len, uint8_t* rx, size_t rx_size, size_t* rx_len);
+
+/**
+ * @brief Send a message to the DEP target, its reply is discarded.
+ * 
+ * @param[in] session Open DEP session.
+ * @param[in] data Message to send.
+ * @param[in] len Length of the message.
+ * 
+ * @return
+ *  - ESP_OK on success.
+ *  - Same errors as pn532_dep_transceive().
+ */
+esp_err_t pn532_dep_send(pn532_dep_session_t* session, const uint8_t* data, size_t len);
+
+/**
+ * @brief Receive a message from the DEP target.
+ * 
+ * Polls the target with an empty message and collects its reply.
+ * 
+ * @param[in] session Open DEP session.
+ * @param[out] data Reply buffer.
+ * @param[in] size Size of the reply buffer.
+ * @param[out] len Length of the reply.
+ * 
+ * @return
+ *  - ESP_OK on success.
+ *  - Same errors as pn532_dep_transceive().
+ */
+esp_err_t pn532_dep_recv(pn532_dep_session_t* session, uint8_t* data, size_t size, size_t* len);
+
+/**
+ * @brief Close a DEP session.
+ * 
+ * Releases the target with InRelease. session->stats stays valid.
+ * 
+ * @param[in] session Open DEP session.
+ * 
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if the session is not open.
+ *  - Other error codes from write and read functions.
+ */
+esp_err_t pn532_dep_close(pn532_dep_session_t* session);
+
+/**
+ * @brief Read PN532 registers.
+ * 
+ * All addresses go out in as few ReadRegister frames as the frame and buffer sizes allow,
+ * in a single request.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[in] addresses CIU (0x63xx) or SFR (0xFFxx) addresses.
+ * @param[out] values One value per address.
+ * @param[in] count Number of addresses.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if an argument is invalid.
+ * - ESP_ERR_INVALID_RESPONSE if the response check failed.
+ * - Other error codes from write and read functions.
+ */
+esp_err_t pn532_read_registers(pn532_handle_t pn532_handle, const uint16_t* addresses, uint8_t* values, size_t count);
+
+/**
+ * @brief Write PN532 registers.
+ * 
+ * Registers are packed into as few WriteRegister frames as possible (84 per frame), in a single request.
+ * CIU registers already holding the requested value according to the handle's shadow cache are skipped,
+ * so re-applying an unchanged profile costs no round-trip at all.
+ * The firmware reprograms the CIU for most commands (InListPassiveTarget, InJumpForDEP, InAutoPoll,
+ * RFConfiguration...), so the cache only lives between register reads and writes: any other command,
+ * a wake up from power down or bringing the PN532 up again drops it.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[in] registers Registers to write, in order.
+ * @param[in] count Number of registers.
+ * @param[out] written Number of registers the PN532 confirmed, the rest was cached or, on error, not written (can be NULL).
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if an argument is invalid.
+ * - ESP_ERR_INVALID_RESPONSE if the response check failed.
+ * - Other error codes from write and read functions.
+ */
+esp_err_t pn532_write_registers(pn532_handle_t pn532_handle, const pn532_register_t* registers, size_t count, size_t* written);
+
+/**
+ * @brief Drop the register shadow cache.
+ * 
+ * The next pn532_write_registers() sends every register.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle is invalid.
+ */
+esp_err_t pn532_invalidate_register_cache(pn532_handle_t pn532_handle);
+
+/**
+ * @brief Put PN532 in power down mode.
+ * 
+ * The RF field is switched off. The next command wakes the PN532 up through the transport
+ * before it is sent, nothing else is needed to resume.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[in] wake_sources Extra PN532_WAKEUP_* sources, the transport's own source is always set.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle is invalid.
+ * - ESP_ERR_INVALID_RESPONSE if the PN532 refused.
+ * - Other errors from the transport.
+ */
+esp_err_t pn532_power_down(pn532_handle_t pn532_handle, uint8_t wake_sources);
+
+/**
+ * @brief Scan for a target with the PN532 powered down in between.
+ * 
+ * Cycles power down, sleep_ms (cut short by the IRQ pin when an extra wake source fired),
+ * wake-up and a short InListPassiveTarget until a target shows up or the timeout expires.
+ * The PN532 is left awake with the target selected.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[in] config Pointer to the low-power configuration.
+ * @param[in] timeout Maximum time to scan in milliseconds.
+ * @param[out] target Pointer to the detected target.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle, config or target is invalid.
+ * - ESP_ERR_NOT_FOUND if no target showed up before the timeout.
+ * - Other errors from the transport.
+ */
+esp_err_t pn532_lowpower_scan(pn532_handle_t pn532_handle, const pn532_lowpower_config_t* config, uint32_t timeout, pn532_target_t* target);
+
+/**
+ * @brief Get PN532 low-power statistics.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[out] stats Pointer to the statistics.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle or stats is invalid.
+ */
+esp_err_t pn532_get_lowpower_stats(pn532_handle_t pn532_handle, pn532_lowpower_stats_t* stats);
+
 /**
  * @brief Read GPIO state.
  * 
@@ -243,4 +1113,253 @@ esp_err_t pn532_read_passive_target_id(pn532_handle_t pn532_handle, uint8_t card
  * - ESP_ERR_INVALID_ARG if the handle or GPIO state buffer is invalid.
  * - ESP_ERR_INVALID_RESPONSE if the command check or ackowledgment failed.
  */
-esp_err_t pn532_read_gpio(pn532_handle_t pn532_handle, uint8_t* gpio_state);
\ No newline at end of file
+esp_err_t pn532_read_gpio(pn532_handle_t pn532_handle, uint8_t* gpio_state);
+
+/**
+ * @brief Start continuous hardware scan.
+ * 
+ * Hands polling to the PN532 with InAutoPoll and reissues it from a scan task until stopped.
+ * Detected targets are posted as pn532_scan_event_t to the returned queue, the application
+ * drains it. Events are dropped if the queue is full. Other commands can run between poll cycles:
+ * a command issued on the handle while a cycle runs aborts it within 100 ms, runs, and the scan task
+ * then starts a new cycle. This holds for endless polling (poll_count 0xFF) too.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[in] config Autopoll configuration (only ISO14443A types are supported).
+ * @param[out] events Event queue, owned by the handle until pn532_autopoll_stop().
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle or configuration is invalid.
+ * - ESP_ERR_NOT_SUPPORTED if a target type is not supported.
+ * - ESP_ERR_INVALID_STATE if a scan is already running.
+ * - ESP_ERR_NO_MEM if memory allocation failed.
+ */
+esp_err_t pn532_autopoll_start(pn532_handle_t pn532_handle, const pn532_autopoll_config_t* config, QueueHandle_t* events);
+
+/**
+ * @brief Stop continuous hardware scan.
+ * 
+ * Aborts the running InAutoPoll, stops the scan task and deletes the event queue.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle is invalid.
+ * - ESP_ERR_INVALID_STATE if no scan is running.
+ */
+esp_err_t pn532_autopoll_stop(pn532_handle_t pn532_handle);
+
+/**
+ * @brief Read MIFARE Classic sectors.
+ * 
+ * Authenticates once per sector and reads all of its blocks (trailer included) with InDataExchange.
+ * Blocks are streamed into data in sector order, 16 bytes each. The authenticated session is reused
+ * across calls while the target stays selected and no other command runs in between.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[in] target Selected target (from pn532_list_passive_targets).
+ * @param[in] sectors Sectors to read and their keys.
+ * @param[in] num_sectors Number of sectors.
+ * @param[out] data Buffer to store the blocks (4 or 16 blocks of 16 bytes per sector).
+ * @param[in] data_size Size of the data buffer.
+ * @param[out] data_len Number of bytes read (also set on failure).
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle, target, sectors or buffers are invalid.
+ * - ESP_ERR_INVALID_SIZE if the data buffer is too small.
+ * - ESP_ERR_INVALID_RESPONSE if authentication or a read failed.
+ */
+esp_err_t pn532_mifare_classic_read_sectors(pn532_handle_t pn532_handle, const pn532_target_t* target, const pn532_mifare_sector_t* sectors, size_t num_sectors, uint8_t* data, size_t data_size, size_t* data_len);
+
+/**
+ * @brief Write MIFARE Classic sectors.
+ * 
+ * Authenticates once per sector and writes its data blocks. Sector trailers and the
+ * manufacturer block are never written, data holds the remaining blocks in sector order.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[in] target Selected target (from pn532_list_passive_targets).
+ * @param[in] sectors Sectors to write and their keys.
+ * @param[in] num_sectors Number of sectors.
+ * @param[in] data Blocks to write, 16 bytes each.
+ * @param[in] data_len Length of data (must match the number of data blocks).
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle, target, sectors or data are invalid.
+ * - ESP_ERR_INVALID_SIZE if data_len does not match the sectors.
+ * - ESP_ERR_INVALID_RESPONSE if authentication or a write failed.
+ */
+esp_err_t pn532_mifare_classic_write_sectors(pn532_handle_t pn532_handle, const pn532_target_t* target, const pn532_mifare_sector_t* sectors, size_t num_sectors, const uint8_t* data, size_t data_len);
+
+/**
+ * @brief Get NTAG/Ultralight version.
+ * 
+ * Sends GET_VERSION to the selected tag through InCommunicateThru.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[out] version Buffer to store the version (buffer MUST have atleast PN532_NTAG_VERSION_LEN bytes).
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle or version buffer is invalid.
+ * - ESP_ERR_INVALID_RESPONSE if the tag did not answer.
+ */
+esp_err_t pn532_ntag_get_version(pn532_handle_t pn532_handle, uint8_t* version);
+
+/**
+ * @brief Read NTAG/Ultralight pages.
+ * 
+ * Reads len bytes starting at start_page with FAST_READ, using the largest ranges
+ * the PN532 and the handle buffer allow (configure a bigger buffer for fewer exchanges).
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[in] start_page First page to read.
+ * @param[out] data Buffer to store the pages.
+ * @param[in] len Number of bytes to read.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle or buffer is invalid.
+ * - ESP_ERR_INVALID_RESPONSE if a read failed.
+ */
+esp_err_t pn532_ntag_read(pn532_handle_t pn532_handle, uint8_t start_page, uint8_t* data, size_t len);
+
+/**
+ * @brief Read NTAG/Ultralight user memory.
+ * 
+ * Works out the user memory size from GET_VERSION and reads all of it with FAST_READ,
+ * in the fewest exchanges the frame size allows.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[out] data Buffer to store the user memory (PN532_NTAG_MAX_USER_MEMORY fits any supported tag).
+ * @param[in] data_size Size of the data buffer.
+ * @param[out] data_len Number of bytes read.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle or buffers are invalid.
+ * - ESP_ERR_INVALID_SIZE if the data buffer is too small.
+ * - ESP_ERR_NOT_SUPPORTED if the tag type is unknown.
+ * - ESP_ERR_INVALID_RESPONSE if the tag did not answer.
+ */
+esp_err_t pn532_ntag_read_user_memory(pn532_handle_t pn532_handle, uint8_t* data, size_t data_size, size_t* data_len);
+
+/**
+ * @brief Get PN532 statistics.
+ * 
+ * Copies the per-command counters and latency histograms of the handle.
+ * Never blocks the transport, the copy is retried if a transaction recorded meanwhile.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * @param[out] stats Pointer to the snapshot.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle or stats is invalid.
+ * - ESP_ERR_NOT_SUPPORTED if CONFIG_PN532_STATS is disabled.
+ */
+esp_err_t pn532_get_stats(pn532_handle_t pn532_handle, pn532_stats_t* stats);
+
+/**
+ * @brief Reset PN532 statistics.
+ * 
+ * @param[in] pn532_handle PN532 handle.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle is invalid.
+ * - ESP_ERR_NOT_SUPPORTED if CONFIG_PN532_STATS is disabled.
+ */
+esp_err_t pn532_reset_stats(pn532_handle_t pn532_handle);
+
+/**
+ * @brief Initialize a PN532 reader group.
+ * 
+ * Initializes every reader, each one keeps its own transport and lock.
+ * 
+ * @param[out] group_handle Pointer to the group handle.
+ * @param[in] config Pointer to the group configuration.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle or config is invalid.
+ * - ESP_ERR_NO_MEM if there is no memory.
+ * - Other errors from pn532_init().
+ */
+esp_err_t pn532_group_init(pn532_group_handle_t* group_handle, const pn532_group_config_t* config);
+
+/**
+ * @brief Free a PN532 reader group.
+ * 
+ * Stops the group if running and frees every reader.
+ * 
+ * @param[in] group_handle Group handle.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle is invalid.
+ */
+esp_err_t pn532_group_free(pn532_group_handle_t group_handle);
+
+/**
+ * @brief Start scanning on every reader of the group.
+ * 
+ * Wakes and configures each reader, then runs its autopoll scan in its own task.
+ * Detections of all readers go to one queue, in the order they were reported, tagged with the reader index.
+ * 
+ * @param[in] group_handle Group handle.
+ * @param[out] events Event queue (pn532_scan_event_t), owned by the group until pn532_group_stop().
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle or events is invalid.
+ * - ESP_ERR_INVALID_STATE if the group is already running.
+ * - ESP_ERR_NO_MEM if there is no memory.
+ * - Other errors from the reader bring up.
+ */
+esp_err_t pn532_group_start(pn532_group_handle_t group_handle, QueueHandle_t* events);
+
+/**
+ * @brief Stop scanning on every reader of the group.
+ * 
+ * @param[in] group_handle Group handle.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle is invalid.
+ * - ESP_ERR_INVALID_STATE if the group is not running.
+ */
+esp_err_t pn532_group_stop(pn532_group_handle_t group_handle);
+
+/**
+ * @brief Get a reader of the group.
+ * 
+ * The handle stays usable for any other command while the group scans.
+ * 
+ * @param[in] group_handle Group handle.
+ * @param[in] reader Reader index.
+ * @param[out] pn532_handle Pointer to the reader handle.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle, index or pn532_handle is invalid.
+ */
+esp_err_t pn532_group_get_reader(pn532_group_handle_t group_handle, size_t reader, pn532_handle_t* pn532_handle);
+
+/**
+ * @brief Get PN532 reader group statistics.
+ * 
+ * Command statistics are summed over the readers (left empty if CONFIG_PN532_STATS is disabled).
+ * 
+ * @param[in] group_handle Group handle.
+ * @param[out] stats Pointer to the snapshot.
+ * 
+ * @return
+ * - ESP_OK on success.
+ * - ESP_ERR_INVALID_ARG if the handle or stats is invalid.
+ */
+esp_err_t pn532_group_get_stats(pn532_group_handle_t group_handle, pn532_group_stats_t* stats);
@@ -1,36 +1,163 @@
+#pragma once
+
 #include "pn532.h"
 
+#include <stdatomic.h>
+
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
 
 #if CONFIG_LOG_DEFAULT_LEVEL >= 4 // 4 = LOG_LEVEL_DEBUG
     #define PN532_DEBUG
 #endif
 
-#define PN532_BUFFER_SIZE 256
+#define ACK_OFFSET 6 // responses are stored right after the ack frame
+
+// the async worker is woken up on notification index 0, IRQ edges get their own index when the kernel has one
+// (CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES >= 2), otherwise both share index 0
+#if configTASK_NOTIFICATION_ARRAY_ENTRIES > 1
+    #define PN532_IRQ_NOTIFY_INDEX 1
+#else
+    #define PN532_IRQ_NOTIFY_INDEX 0
+#endif
+
+// one part of a frame handed to the transport (header, command, payload, trailer)
+typedef struct {
+    const uint8_t* data;
+    size_t len;
+} pn532_iovec_t;
 
 typedef struct {
     uart_port_t uart_port;
+    uint32_t baud_rate;
 } uart_specifics_t;
 
 typedef struct {
-    // todo
+    i2c_master_bus_handle_t bus;
+    i2c_master_dev_handle_t dev;
+    bool owns_bus; // bus was created for this handle
+    uint32_t clk_speed;
 } i2c_specifics_t;
 
 typedef struct {
-    // todo
+    spi_device_handle_t dev;
+    spi_host_device_t host;
+    bool owns_bus; // bus was initialized for this handle
+    uint8_t* tx; // DMA capable
+    uint8_t* rx; // DMA capable
+    size_t rx_size;
 } spi_specifics_t;
 
+typedef struct {
+    gpio_num_t pin; // GPIO_NUM_NC when not used
+    volatile TaskHandle_t waiting_task;
+} irq_specifics_t;
+
+typedef struct {
+    TaskHandle_t task; // NULL when async mode is disabled
+    QueueHandle_t queues[PN532_PRIORITY_MAX];
+    SemaphoreHandle_t stopped;
+    volatile bool stopping; // set by pn532_async_stop(), new requests are refused
+    atomic_uint waiting; // tasks blocked on the handle mutex in pn532_run() (sync mode)
+} async_specifics_t;
+
+typedef struct {
+    uint8_t uid[PN532_MAX_UID_LEN];
+    uint8_t uid_len; // 0 for a free slot
+    uint8_t type;
+    uint8_t sak;
+    int64_t last_seen_us;
+} uid_cache_entry_t;
+
+typedef struct {
+    #if PN532_UID_CACHE_SIZE > 0
+        uid_cache_entry_t entries[PN532_UID_CACHE_SIZE]; // open addressing, linear probing
+        size_t count;
+    #endif
+} uid_cache_specifics_t;
+
+typedef struct {
+    TaskHandle_t task; // NULL when not scanning
+    QueueHandle_t events;
+    bool shared; // events belongs to a reader group
+    uint8_t reader; // tag for posted events
+    SemaphoreHandle_t stopped;
+    volatile bool stop;
+    atomic_uint posted; // counted by the scan task, read by any task
+    atomic_uint dropped; // events lost to a full queue
+    pn532_autopoll_config_t config;
+    uid_cache_specifics_t cache;
+} autopoll_specifics_t;
+
+typedef struct {
+    bool authenticated; // cleared by any command other than InDataExchange
+    uint8_t tg;
+    uint8_t sector;
+    uint8_t key_type;
+    uint8_t key[6];
+    uint8_t uid[4];
+} mifare_session_t;
+
+typedef struct {
+    #ifdef CONFIG_PN532_STATS
+        uint32_t seq; // odd while a transaction is recording
+        uint8_t slots[256]; // command code -> slot + 1, 0 when unassigned
+        size_t num_commands;
+        pn532_command_stats_t commands[PN532_STATS_MAX_COMMANDS];
+        pn532_command_stats_t* current; // command in flight
+        int64_t ack_at;
+    #endif
+} stats_specifics_t;
+
+typedef struct {
+    bool powered_down; // the next command wakes the PN532 up first
+    int64_t down_at;
+    pn532_lowpower_stats_t stats;
+} power_specifics_t;
+
+typedef struct {
+    uint8_t values[PN532_CIU_SIZE]; // last value written to each CIU register
+    uint64_t valid; // one bit per CIU register with a known value
+} register_cache_specifics_t;
+
 typedef struct pn532_t {
-    uint8_t buffer[PN532_BUFFER_SIZE];
     pn532_protocol_t protocol;
     union {
         uart_specifics_t uart;
         i2c_specifics_t i2c;
         spi_specifics_t spi;
     };
+    size_t response_len; // length of the last response frame (stored after the ack)
+    const uint8_t* response_data; // TFI of the last response frame, normal or extended
+    size_t response_data_len; // LEN of the last response frame (TFI included)
+    irq_specifics_t irq;
+    async_specifics_t async;
+    autopoll_specifics_t autopoll;
+    mifare_session_t mifare;
+    stats_specifics_t stats;
+    power_specifics_t power;
+    register_cache_specifics_t registers;
     SemaphoreHandle_t mutex;
-    esp_err_t (*write_command)(struct pn532_t* pn532, uint8_t* command, uint8_t command_len);
-    esp_err_t (*read_response)(struct pn532_t* pn532, TickType_t timeout);
+    StaticSemaphore_t mutex_storage;
+    bool static_storage; // created by pn532_init_static(), not freed
+    esp_err_t (*write_frame)(struct pn532_t* pn532, const pn532_iovec_t* iov, size_t iov_count);
+    esp_err_t (*write_raw)(struct pn532_t* pn532, const uint8_t* data, size_t len);
+    esp_err_t (*read_frame)(struct pn532_t* pn532, uint8_t* frame, size_t frame_size, size_t* frame_len, TickType_t timeout);
+    esp_err_t (*set_baud_rate)(struct pn532_t* pn532, uint32_t baud_rate); // NULL if not supported by protocol
+    esp_err_t (*wake_up)(struct pn532_t* pn532); // brings the PN532 out of power down, ready for the next frame
     esp_err_t (*free)(struct pn532_t* pn532);
-} pn532_t;
\ No newline at end of file
+    size_t buffer_size;
+    uint8_t buffer[]; // ack + response frame, sized by configuration
+} pn532_t;
+
+// storage for pn532_init_static()
+#define PN532_STATIC_HANDLE_SIZE (sizeof(pn532_t) + PN532_DEFAULT_BUFFER_SIZE)
+
+typedef struct {
+    _Alignas(pn532_t) uint8_t storage[PN532_STATIC_HANDLE_SIZE];
+} pn532_static_t;
+
+// unit of work that runs with exclusive access to the transport
+typedef esp_err_t (*pn532_job_t)(pn532_t* pn532, void* ctx);
\ No newline at end of file
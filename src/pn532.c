@@ -4,48 +4,133 @@
 #include <string.h>
 
 #include "esp_log.h"
-
-#define PN532_MAX_CARDS 1
-#define ACK_OFFSET 6
+#include "esp_timer.h"
 
 #define PN532_DEFAULT_TIMEOUT 100
+#define PN532_ACK_TIMEOUT 30
+#define PN532_PRESENT_TIMEOUT 50 // the PN532 gives up on a silent target well before this
+
+#ifdef CONFIG_PN532_NACK_RETRIES
+    #define PN532_NACK_RETRIES CONFIG_PN532_NACK_RETRIES
+#else
+    #define PN532_NACK_RETRIES 3
+#endif
+
+#define PN532_DIAGNOSE_ATTENTION 0x06
+#define PN532_ULTRALIGHT_READ 0x30
+
+typedef struct {
+    const uint8_t* command;
+    size_t command_len;
+    uint32_t ack_timeout;
+    uint32_t response_timeout;
+    pn532_latency_t* latency;
+    uint8_t* response; // private copy of the response frame (can be NULL)
+    size_t response_size;
+} pn532_command_job_t;
 
 static const char* TAG = "pn532";
 
 static uint8_t pn532_ack[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+static const uint8_t pn532_nack[] = {0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00};
 static uint8_t pn532_firmwareversion[] = {0x00, 0x00, 0xFF, 0x06, 0xFA, 0xD5};
 
 extern esp_err_t pn532_uart_init(pn532_t* pn532, const pn532_uart_config_t* config);
+extern esp_err_t pn532_i2c_init(pn532_t* pn532, const pn532_i2c_config_t* config);
+extern esp_err_t pn532_spi_init(pn532_t* pn532, const pn532_spi_config_t* config);
+extern esp_err_t pn532_irq_wait(pn532_t* pn532, TickType_t timeout);
+extern esp_err_t pn532_async_start(pn532_t* pn532, const pn532_async_config_t* config);
+extern void pn532_async_stop(pn532_t* pn532);
+extern esp_err_t pn532_run(pn532_t* pn532, pn532_priority_t priority, pn532_job_t job, void* ctx);
+extern void pn532_stats_record_ack(pn532_t* pn532, uint8_t command, size_t bytes_out, uint32_t write_time_us, uint32_t ack_latency_us, esp_err_t err);
+extern void pn532_stats_record_response(pn532_t* pn532, size_t bytes_in, esp_err_t err);
+extern void pn532_stats_record_retry(pn532_t* pn532);
+extern esp_err_t pn532_wake(pn532_t* pn532);
+extern void pn532_register_cache_clear(pn532_t* pn532);
 
-esp_err_t pn532_init(pn532_handle_t* pn532_handle, const pn532_config_t* config) {
-    if(!pn532_handle || !config) {
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    pn532_t* pn532 = (pn532_t*) malloc(sizeof(pn532_t));
-    if(!pn532) {
-        return ESP_ERR_NO_MEM;
-    }
-    memset(pn532, 0, sizeof(pn532_t));
-
+// brings up a zeroed handle, on failure everything but the handle memory is released
+static esp_err_t pn532_setup(pn532_t* pn532, const pn532_config_t* config) {
     esp_err_t err = ESP_OK;
     switch(config->protocol) {
         case PN532_UART_PROTOCOL:
             err = pn532_uart_init(pn532, &config->uart);
             break;
         case PN532_I2C_PROTOCOL:
-            // todo
+            err = pn532_i2c_init(pn532, &config->i2c);
             break;
         case PN532_SPI_PROTOCOL:
-            // todo
+            err = pn532_spi_init(pn532, &config->spi);
             break;
         default:
             ESP_LOGE(TAG, "unknown protocol");
-            free(pn532);
             err = ESP_ERR_INVALID_ARG;
             break;
     }
 
+    // a transport that failed has already released its own resources
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    // never fails, the handle holds the mutex
+    pn532->mutex = xSemaphoreCreateMutexStatic(&pn532->mutex_storage);
+
+    if(config->async.enabled) {
+        err = pn532_async_start(pn532, &config->async);
+        if(err != ESP_OK) {
+            vSemaphoreDelete(pn532->mutex);
+            (void) pn532->free(pn532);
+            return err;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t pn532_init(pn532_handle_t* pn532_handle, const pn532_config_t* config) {
+    if(!pn532_handle || !config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t buffer_size = config->buffer_size ? config->buffer_size : PN532_DEFAULT_BUFFER_SIZE;
+    if(buffer_size < PN532_MIN_BUFFER_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) malloc(sizeof(pn532_t) + buffer_size);
+    if(!pn532) {
+        return ESP_ERR_NO_MEM;
+    }
+    memset(pn532, 0, sizeof(pn532_t));
+    pn532->buffer_size = buffer_size;
+
+    esp_err_t err = pn532_setup(pn532, config);
+    if(err != ESP_OK) {
+        free(pn532);
+        return err;
+    }
+
+    *pn532_handle = pn532;
+    return ESP_OK;
+}
+
+esp_err_t pn532_init_static(pn532_handle_t* pn532_handle, const pn532_config_t* config, void* storage) {
+    if(!pn532_handle || !config || !storage) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // the storage is sized for the configured default buffer, a smaller one leaves some unused
+    size_t buffer_size = config->buffer_size ? config->buffer_size : PN532_DEFAULT_BUFFER_SIZE;
+    if(buffer_size < PN532_MIN_BUFFER_SIZE || buffer_size > PN532_DEFAULT_BUFFER_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) storage;
+    memset(pn532, 0, sizeof(pn532_t));
+    pn532->buffer_size = buffer_size;
+    pn532->static_storage = true;
+
+    esp_err_t err = pn532_setup(pn532, config);
     if(err != ESP_OK) {
         return err;
     }
@@ -61,16 +146,292 @@ esp_err_t pn532_free(pn532_handle_t pn532_handle) {
 
     pn532_t* pn532 = (pn532_t*) pn532_handle;
 
+    (void) pn532_autopoll_stop(pn532);
+    pn532_async_stop(pn532);
+
     esp_err_t err = pn532->free(pn532);
     if(err != ESP_OK) {
         return err;
     }
 
-    free(pn532);
+    vSemaphoreDelete(pn532->mutex);
+    if(!pn532->static_storage) {
+        free(pn532);
+    }
+
+    return ESP_OK;
+}
+
+// frames command + data (data can be NULL) without copying either, the caller must hold the handle mutex
+esp_err_t pn532_write_frame(pn532_t* pn532, const uint8_t* command, size_t command_len, const uint8_t* data, size_t data_len) {
+    size_t len = command_len + data_len + 1; // TFI included
+    if(len > PN532_MAX_FRAME_DATA) {
+        ESP_LOGE(TAG, "command too long: %d", (int) len);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // normal frame: 00 00 FF LEN LCS TFI, extended frame: 00 00 FF FF FF LENm LENl LCS TFI
+    uint8_t header[9] = {
+        PN532_PREAMBLE,
+        PN532_STARTCODE1,
+        PN532_STARTCODE2,
+    };
+    size_t header_len = 3;
+    if(len > 0xFF) {
+        header[header_len++] = 0xFF;
+        header[header_len++] = 0xFF;
+        header[header_len++] = len >> 8;
+        header[header_len++] = len & 0xFF;
+        header[header_len++] = ~((len >> 8) + (len & 0xFF)) + 1;
+    } else {
+        header[header_len++] = len;
+        header[header_len++] = ~len + 1;
+    }
+    header[header_len++] = PN532_HOSTTOPN532;
+
+    // single pass over the payload, only for the checksum
+    uint8_t checksum = PN532_HOSTTOPN532;
+    for(size_t i = 0; i < command_len; i++) {
+        checksum += command[i];
+    }
+    for(size_t i = 0; i < data_len; i++) {
+        checksum += data[i];
+    }
+
+    uint8_t trailer[] = {
+        ~checksum + 1,
+        PN532_POSTAMBLE,
+    };
+
+    const pn532_iovec_t iov[] = {
+        {header, header_len},
+        {command, command_len},
+        {data, data_len},
+        {trailer, sizeof(trailer)},
+    };
+    return pn532->write_frame(pn532, iov, sizeof(iov) / sizeof(iov[0]));
+}
+
+// for transports that read frames in blocks: finds the start code in the first bytes of a frame (raw)
+// start is the offset of the first byte after 00 FF, total the frame length once normalized to 00 00 FF ...
+esp_err_t pn532_parse_frame_header(const uint8_t* raw, size_t raw_len, size_t* start, size_t* total) {
+    size_t i = 1;
+    while(i < raw_len && !(raw[i - 1] == PN532_STARTCODE1 && raw[i] == PN532_STARTCODE2)) {
+        i++;
+    }
+    if(i + 2 >= raw_len) {
+        ESP_LOGE(TAG, "failed to find start code");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    const uint8_t* code = &raw[i + 1];
+    if((code[0] == 0x00 && code[1] == 0xFF) || (code[0] == 0xFF && code[1] == 0x00)) {
+        // ack (00 FF) and nack (FF 00) frames carry no data, only the postamble
+        *total = 6;
+    } else if(code[0] == 0xFF && code[1] == 0xFF) {
+        // extended frame: 00 00 FF FF FF LENm LENl LCS
+        if(i + 5 >= raw_len) {
+            ESP_LOGE(TAG, "failed to read extended header");
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        if((uint8_t) (code[2] + code[3] + code[4]) != 0) {
+            ESP_LOGE(TAG, "invalid length checksum");
+            return ESP_ERR_INVALID_CRC;
+        }
+        *total = 8 + ((code[2] << 8) | code[3]) + 2;
+    } else {
+        if((uint8_t) (code[0] + code[1]) != 0) {
+            ESP_LOGE(TAG, "invalid length checksum");
+            return ESP_ERR_INVALID_CRC;
+        }
+        *total = 5 + code[0] + 2;
+    }
+
+    *start = i + 1;
+    return ESP_OK;
+}
+
+// checks the data checksum of a complete, normalized frame
+esp_err_t pn532_check_frame(const uint8_t* frame, size_t total) {
+    if(total <= 6) {
+        return ESP_OK;
+    }
+
+    size_t header_len = (frame[3] == 0xFF && frame[4] == 0xFF) ? 8 : 5;
+    uint8_t checksum = 0;
+    for(size_t i = header_len; i < total - 1; i++) {
+        checksum += frame[i];
+    }
+    if(checksum != 0) {
+        ESP_LOGE(TAG, "invalid data checksum");
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    return ESP_OK;
+}
+
+// writes a command (+ optional data) and waits for its ack, the caller must hold the handle mutex
+esp_err_t pn532_write_command_check_ack(pn532_t* pn532, const uint8_t* command, size_t command_len, const uint8_t* data, size_t data_len, uint32_t ack_timeout, uint32_t* ack_latency_us) {
+    pn532->response_len = 0;
+    pn532->response_data = NULL;
+    pn532->response_data_len = 0;
+
+    // anything but a data exchange may reselect or release the target
+    if(command[0] != PN532_COMMAND_INDATAEXCHANGE) {
+        pn532->mifare.authenticated = false;
+    }
+
+    // the firmware reprograms the CIU for most commands (polling, DEP, RF settings), only register access leaves it alone
+    if(command[0] != PN532_COMMAND_READREGISTER && command[0] != PN532_COMMAND_WRITEREGISTER) {
+        pn532_register_cache_clear(pn532);
+    }
+
+    if(pn532->power.powered_down) {
+        esp_err_t err = pn532_wake(pn532);
+        if(err != ESP_OK) {
+            return err;
+        }
+    }
+
+    int64_t started_at = esp_timer_get_time();
+    int64_t written_at = started_at;
+    uint32_t latency_us = 0;
+
+    esp_err_t err = pn532_write_frame(pn532, command, command_len, data, data_len);
+    if(err != ESP_OK) {
+        goto END;
+    }
+    written_at = esp_timer_get_time();
+
+    #ifdef PN532_DEBUG
+        ESP_LOGD(TAG, "reading ack:");
+    #endif
+
+    // anything but an ack is stale (e.g. the late response of a command that timed out) and skipped
+    TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(ack_timeout);
+    while(true) {
+        TickType_t now = xTaskGetTickCount();
+        TickType_t remaining = ((int32_t) (deadline - now) > 0) ? (deadline - now) : 0;
+
+        size_t frame_len = 0;
+        err = pn532->read_frame(pn532, pn532->buffer, ACK_OFFSET, &frame_len, remaining);
+        if(err == ESP_OK && frame_len == sizeof(pn532_ack) && !memcmp(pn532->buffer, pn532_ack, sizeof(pn532_ack))) {
+            break;
+        }
+
+        if(err == ESP_ERR_TIMEOUT) {
+            ESP_LOGE(TAG, "failed to read ack");
+            goto END;
+        }
+
+        if(!remaining) {
+            ESP_LOGE(TAG, "failed to check ack");
+            err = ESP_ERR_INVALID_RESPONSE;
+            goto END;
+        }
+
+        #ifdef PN532_DEBUG
+            ESP_LOGD(TAG, "skipping stale frame: %d", err);
+        #endif
+    }
+
+    latency_us = (uint32_t) (esp_timer_get_time() - written_at);
+    if(ack_latency_us) {
+        *ack_latency_us = latency_us;
+    }
+
+END:
+    pn532_stats_record_ack(pn532, command[0], command_len + data_len, (uint32_t) (written_at - started_at), latency_us, err);
+    return err;
+}
+
+// reads the response frame into the buffer right after the ack, the caller must hold the handle mutex
+// ESP_ERR_TIMEOUT means the device stayed silent, so it is safe to call again
+esp_err_t pn532_read_response(pn532_t* pn532, uint32_t timeout) {
+    // the IRQ and the frame share one deadline, a late IRQ must not restart the timeout
+    TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(timeout);
+    esp_err_t err = pn532_irq_wait(pn532, pdMS_TO_TICKS(timeout));
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    size_t frame_len = 0;
+    for(size_t retries = 0; ; retries++) {
+        TickType_t now = xTaskGetTickCount();
+        TickType_t remaining = ((int32_t) (deadline - now) > 0) ? (deadline - now) : 0;
+
+        err = pn532->read_frame(pn532, pn532->buffer + ACK_OFFSET, pn532->buffer_size - ACK_OFFSET, &frame_len, remaining);
+        if(err != ESP_ERR_INVALID_CRC || retries >= PN532_NACK_RETRIES) {
+            break;
+        }
+
+        // a nack makes the PN532 send its last response again, without repeating the command
+        ESP_LOGW(TAG, "corrupt response, requesting it again");
+        pn532_stats_record_retry(pn532);
+        err = pn532->write_raw(pn532, pn532_nack, sizeof(pn532_nack));
+        if(err != ESP_OK) {
+            break;
+        }
+    }
+    if(err != ESP_OK) {
+        // a timeout only counts once the caller gives up
+        if(err != ESP_ERR_TIMEOUT) {
+            pn532_stats_record_response(pn532, 0, err);
+        }
+        return err;
+    }
+
+    pn532->response_len = frame_len;
+    pn532_stats_record_response(pn532, frame_len, ESP_OK);
+
+    const uint8_t* frame = pn532->buffer + ACK_OFFSET;
+    if(frame[3] == 0xFF && frame[4] == 0xFF) {
+        pn532->response_data = &frame[8];
+        pn532->response_data_len = (frame[5] << 8) | frame[6];
+    } else {
+        pn532->response_data = &frame[5];
+        pn532->response_data_len = frame[3];
+    }
 
     return ESP_OK;
 }
 
+// runs one command/ack/response exchange, data is sent right after command without being copied
+// the caller must hold the handle mutex
+esp_err_t pn532_transceive_data(pn532_t* pn532, const uint8_t* command, size_t command_len, const uint8_t* data, size_t data_len, uint32_t ack_timeout, uint32_t response_timeout, pn532_latency_t* latency) {
+    uint32_t ack_latency_us = 0;
+    esp_err_t err = pn532_write_command_check_ack(pn532, command, command_len, data, data_len, ack_timeout, &ack_latency_us);
+    if(err != ESP_OK) {
+        return err;
+    }
+    int64_t ack_at = esp_timer_get_time();
+
+    err = pn532_read_response(pn532, response_timeout);
+    if(err != ESP_OK) {
+        if(err == ESP_ERR_TIMEOUT) {
+            pn532_stats_record_response(pn532, 0, err);
+        }
+        ESP_LOGE(TAG, "failed to read response");
+        return err;
+    }
+
+    if(latency) {
+        latency->ack_latency_us = ack_latency_us;
+        latency->response_latency_us = (uint32_t) (esp_timer_get_time() - ack_at);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t pn532_transceive(pn532_t* pn532, const uint8_t* command, size_t command_len, uint32_t ack_timeout, uint32_t response_timeout, pn532_latency_t* latency) {
+    return pn532_transceive_data(pn532, command, command_len, NULL, 0, ack_timeout, response_timeout, latency);
+}
+
+static esp_err_t pn532_start_job(pn532_t* pn532, void* ctx) {
+    // sends a dummy command and ignores ack (i have no idea why, but it was the only way i got it to work) 
+    return pn532_write_frame(pn532, (uint8_t[]) {PN532_COMMAND_GETFIRMWAREVERSION}, 1, NULL, 0);
+}
+
 esp_err_t pn532_start(pn532_handle_t pn532_handle) {
     if(!pn532_handle) {
         return ESP_ERR_INVALID_ARG;
@@ -78,8 +439,7 @@ esp_err_t pn532_start(pn532_handle_t pn532_handle) {
 
     pn532_t* pn532 = (pn532_t*) pn532_handle;
 
-    // sends a dummy command and ignores ack (i have no idea why, but it was the only way i got it to work) 
-    esp_err_t err = pn532->write_command(pn532, (uint8_t[]) {PN532_COMMAND_GETFIRMWAREVERSION}, 1);
+    esp_err_t err = pn532_run(pn532, PN532_PRIORITY_HIGH, pn532_start_job, NULL);
     if(err != ESP_OK) {
         ESP_LOGE(TAG, "failed to start PN532");
         return err;
@@ -89,35 +449,274 @@ esp_err_t pn532_start(pn532_handle_t pn532_handle) {
     return ESP_OK;
 } 
 
-esp_err_t pn532_send_command_check_ack(pn532_handle_t pn532_handle, uint8_t* command, uint8_t command_len, uint32_t timeout) {
+// round-trip used to check the link after a wake-up or a baud rate change, the caller must hold the handle mutex
+static esp_err_t pn532_verify_link(pn532_t* pn532) {
+    esp_err_t err = pn532_transceive(pn532, (uint8_t[]) {PN532_COMMAND_GETFIRMWAREVERSION}, 1, PN532_ACK_TIMEOUT, PN532_DEFAULT_TIMEOUT, NULL);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    if(memcmp(pn532->buffer + ACK_OFFSET, pn532_firmwareversion, sizeof(pn532_firmwareversion)) != 0) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    return ESP_OK;
+}
+
+// sends one RFConfiguration item, the caller must hold the handle mutex
+static esp_err_t pn532_rf_configuration(pn532_t* pn532, const uint8_t* command, size_t command_len) {
+    esp_err_t err = pn532_transceive(pn532, command, command_len, PN532_ACK_TIMEOUT, PN532_DEFAULT_TIMEOUT, NULL);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to configure RF item %02X", command[1]);
+        return err;
+    }
+
+    // D5 33
+    if(pn532->response_data_len < 2 || pn532->response_data[1] != PN532_COMMAND_RFCONFIGURATION + 1) {
+        ESP_LOGE(TAG, "failed to check RF configuration");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    return ESP_OK;
+}
+
+typedef struct {
+    const pn532_bring_up_config_t* config;
+    pn532_bring_up_report_t* report;
+} pn532_bring_up_job_t;
+
+static esp_err_t pn532_bring_up_job(pn532_t* pn532, void* ctx) {
+    pn532_bring_up_job_t* job = (pn532_bring_up_job_t*) ctx;
+    pn532_bring_up_report_t* report = job->report;
+
+    int64_t started_at = esp_timer_get_time();
+
+    // a PN532 put to sleep by this handle is woken up by pn532_wake(), which also keeps the power stats right
+    esp_err_t err = pn532->power.powered_down ? pn532_wake(pn532) : pn532->wake_up(pn532);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to wake up");
+        return err;
+    }
+
+    // the PN532 may have lost power since the last write
+    pn532_register_cache_clear(pn532);
+
+    int64_t now = esp_timer_get_time();
+    report->wake_us = (uint32_t) (now - started_at);
+    int64_t step_at = now;
+
+    // the first frame after power-on can be lost while the PN532 syncs, so the link gets a second chance
+    err = pn532_verify_link(pn532);
+    if(err == ESP_ERR_TIMEOUT || err == ESP_ERR_INVALID_RESPONSE) {
+        (void) pn532->wake_up(pn532);
+        err = pn532_verify_link(pn532);
+    }
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to check link");
+        return err;
+    }
+
+    // D5 03 IC Ver Rev Support
+    memcpy(report->version, &pn532->response_data[2], sizeof(report->version));
+
+    now = esp_timer_get_time();
+    report->link_us = (uint32_t) (now - step_at);
+    step_at = now;
+
+    uint8_t sam_command[] = {
+        PN532_COMMAND_SAMCONFIGURATION,
+        0x01, // normal mode
+        0x14, // timeout 50ms * 20 = 1s
+        0x01, // use IRQ pin
+    };
+    err = pn532_transceive(pn532, sam_command, sizeof(sam_command), PN532_ACK_TIMEOUT, PN532_DEFAULT_TIMEOUT, NULL);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to configure SAM");
+        return err;
+    }
+
+    if(pn532->response_data_len < 2 || pn532->response_data[1] != PN532_COMMAND_SAMCONFIGURATION + 1) {
+        ESP_LOGE(TAG, "failed to check SAM configuration");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    now = esp_timer_get_time();
+    report->sam_us = (uint32_t) (now - step_at);
+    step_at = now;
+
+    uint8_t rf_command[] = {
+        PN532_COMMAND_RFCONFIGURATION,
+        0x05, // configuration item
+        0xFF, // MxRtyATR (default 0xFF)
+        0x01, // MxRtyPSL (default 0x01)
+        job->config->passive_activation_retries,
+    };
+    err = pn532_rf_configuration(pn532, rf_command, sizeof(rf_command));
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    now = esp_timer_get_time();
+    report->rf_us = (uint32_t) (now - step_at);
+    report->total_us = (uint32_t) (now - started_at);
+
+    return ESP_OK;
+}
+
+esp_err_t pn532_bring_up(pn532_handle_t pn532_handle, const pn532_bring_up_config_t* config, pn532_bring_up_report_t* report) {
+    if(!pn532_handle || !config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    pn532_bring_up_report_t local_report;
+    pn532_bring_up_job_t job = {
+        .config = config,
+        .report = report ? report : &local_report,
+    };
+    memset(job.report, 0, sizeof(pn532_bring_up_report_t));
+
+    esp_err_t err = pn532_run(pn532, PN532_PRIORITY_HIGH, pn532_bring_up_job, &job);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to bring up PN532");
+        return err;
+    }
+
+    ESP_LOGI(TAG, "PN5%02X %02X.%02X up in %lu us", job.report->version[0], job.report->version[1], job.report->version[2], (unsigned long) job.report->total_us);
+    return ESP_OK;
+}
+
+static esp_err_t pn532_command_job(pn532_t* pn532, void* ctx) {
+    pn532_command_job_t* job = (pn532_command_job_t*) ctx;
+
+    esp_err_t err = pn532_transceive(pn532, job->command, job->command_len, job->ack_timeout, job->response_timeout, job->latency);
+    if(err != ESP_OK || !job->response) {
+        return err;
+    }
+
+    // private copy of the response frame, the handle buffer belongs to the next request
+    size_t len = (pn532->response_len < job->response_size) ? pn532->response_len : job->response_size;
+    memset(job->response, 0, job->response_size);
+    memcpy(job->response, pn532->buffer + ACK_OFFSET, len);
+
+    return ESP_OK;
+}
+
+// sends a command and copies the response frame into response
+static esp_err_t pn532_command(pn532_t* pn532, pn532_priority_t priority, uint8_t* command, size_t command_len, uint32_t timeout, uint8_t* response, size_t response_size) {
+    pn532_command_job_t job = {
+        .command = command,
+        .command_len = command_len,
+        .ack_timeout = PN532_ACK_TIMEOUT,
+        .response_timeout = timeout,
+        .response = response,
+        .response_size = response_size,
+    };
+    return pn532_run(pn532, priority, pn532_command_job, &job);
+}
+
+esp_err_t pn532_send_command_check_ack(pn532_handle_t pn532_handle, uint8_t* command, size_t command_len, uint32_t timeout) {
+    return pn532_send_command_timed(pn532_handle, command, command_len, PN532_ACK_TIMEOUT, timeout, NULL);
+}
+
+esp_err_t pn532_send_command_timed(pn532_handle_t pn532_handle, uint8_t* command, size_t command_len, uint32_t ack_timeout, uint32_t response_timeout, pn532_latency_t* latency) {
     if(!pn532_handle || !command) {
         return ESP_ERR_INVALID_ARG;
     }
 
     pn532_t* pn532 = (pn532_t*) pn532_handle;
-    
-    vTaskDelay(20 / portTICK_PERIOD_MS);
-    esp_err_t err = pn532->write_command(pn532, command, command_len);
+
+    pn532_command_job_t job = {
+        .command = command,
+        .command_len = command_len,
+        .ack_timeout = ack_timeout,
+        .response_timeout = response_timeout,
+        .latency = latency,
+    };
+    return pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_command_job, &job);
+}
+
+static esp_err_t pn532_baud_rate_code(uint32_t baud_rate, uint8_t* code) {
+    static const uint32_t baud_rates[] = {9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600, 1288000};
+
+    for(size_t i = 0; i < sizeof(baud_rates) / sizeof(baud_rates[0]); i++) {
+        if(baud_rates[i] == baud_rate) {
+            *code = i;
+            return ESP_OK;
+        }
+    }
+
+    return ESP_ERR_INVALID_ARG;
+}
+
+static esp_err_t pn532_set_serial_baud_rate_job(pn532_t* pn532, void* ctx) {
+    uint32_t baud_rate = *(uint32_t*) ctx;
+
+    uint8_t code = 0;
+    esp_err_t err = pn532_baud_rate_code(baud_rate, &code);
     if(err != ESP_OK) {
+        ESP_LOGE(TAG, "unsupported baud rate: %lu", (unsigned long) baud_rate);
         return err;
     }
 
-    #ifdef PN532_DEBUG
-        ESP_LOGD(TAG, "reading ack:");
-    #endif
+    uint32_t previous_baud_rate = pn532->uart.baud_rate;
 
-    vTaskDelay(20 / portTICK_PERIOD_MS);
-    err = pn532->read_response(pn532, (timeout / portTICK_PERIOD_MS));
+    uint8_t command[] = {
+        PN532_COMMAND_SETSERIALBAUDRATE,
+        code,
+    };
+    err = pn532_transceive(pn532, command, sizeof(command), PN532_ACK_TIMEOUT, PN532_DEFAULT_TIMEOUT, NULL);
     if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to set serial baud rate");
         return err;
     }
 
-    if(memcmp(pn532->buffer, pn532_ack, sizeof(pn532_ack)) != 0) {
-        ESP_LOGE(TAG, "failed to check ack");
+    if(pn532->buffer[ACK_OFFSET + 6] != PN532_COMMAND_SETSERIALBAUDRATE + 1) {
+        ESP_LOGE(TAG, "failed to check serial baud rate response");
         return ESP_ERR_INVALID_RESPONSE;
     }
 
-    return ESP_OK;
+    // the PN532 only switches once the host acknowledges the response
+    err = pn532->write_raw(pn532, pn532_ack, sizeof(pn532_ack));
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    err = pn532->set_baud_rate(pn532, baud_rate);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    err = pn532_verify_link(pn532);
+    if(err == ESP_OK) {
+        ESP_LOGI(TAG, "serial baud rate set to %lu", (unsigned long) baud_rate);
+        return ESP_OK;
+    }
+
+    // fall back to the previous baud rate, the PN532 may have never switched
+    ESP_LOGW(TAG, "link check failed at %lu, falling back to %lu", (unsigned long) baud_rate, (unsigned long) previous_baud_rate);
+    (void) pn532->set_baud_rate(pn532, previous_baud_rate);
+    if(pn532_verify_link(pn532) != ESP_OK) {
+        ESP_LOGE(TAG, "link lost after baud rate change");
+    }
+
+    return ESP_ERR_INVALID_RESPONSE;
+}
+
+esp_err_t pn532_set_serial_baud_rate(pn532_handle_t pn532_handle, uint32_t baud_rate) {
+    if(!pn532_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    if(!pn532->set_baud_rate) {
+        ESP_LOGE(TAG, "baud rate change not supported by protocol");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    return pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_set_serial_baud_rate_job, &baud_rate);
 }
 
 esp_err_t pn532_get_firmware_version(pn532_handle_t pn532_handle, uint8_t* version) {
@@ -127,16 +726,13 @@ esp_err_t pn532_get_firmware_version(pn532_handle_t pn532_handle, uint8_t* versi
 
     pn532_t* pn532 = (pn532_t*) pn532_handle;
 
-    esp_err_t err = pn532_send_command_check_ack(pn532, (uint8_t[]) {PN532_COMMAND_GETFIRMWAREVERSION}, 1, PN532_DEFAULT_TIMEOUT);
+    uint8_t response[11];
+    esp_err_t err = pn532_command(pn532, PN532_PRIORITY_HIGH, (uint8_t[]) {PN532_COMMAND_GETFIRMWAREVERSION}, 1, PN532_DEFAULT_TIMEOUT, response, sizeof(response));
     if(err != ESP_OK) {
         ESP_LOGE(TAG, "failed to get firmware version");
         return err;
     }
 
-    uint8_t response[11];
-    size_t len = sizeof(response);
-    memcpy(response, (pn532->buffer + ACK_OFFSET), len);
-
     if(memcmp(response, pn532_firmwareversion, sizeof(pn532_firmwareversion)) != 0) {
         ESP_LOGE(TAG, "failed to check firmware version");
         return ESP_ERR_INVALID_RESPONSE;
@@ -163,16 +759,13 @@ esp_err_t pn532_SAM_configuration(pn532_handle_t pn532_handle) {
         0x14, // timeout 50ms * 20 = 1s
         0x01, // use IRQ pin
     };
-    esp_err_t err = pn532_send_command_check_ack(pn532, command, sizeof(command), PN532_DEFAULT_TIMEOUT);
+    uint8_t response[8];
+    esp_err_t err = pn532_command(pn532, PN532_PRIORITY_NORMAL, command, sizeof(command), PN532_DEFAULT_TIMEOUT, response, sizeof(response));
     if(err != ESP_OK) {
         ESP_LOGE(TAG, "failed to configure SAM");
         return err;
     }
 
-    uint8_t response[8];
-    size_t len = sizeof(response);
-    memcpy(response, (pn532->buffer + ACK_OFFSET), len);
-
     if(response[6] != 0x15) {
         ESP_LOGE(TAG, "failed to check SAM configuration");
         return ESP_ERR_INVALID_RESPONSE;
@@ -200,7 +793,7 @@ esp_err_t pn532_set_passive_activation_retries(pn532_handle_t pn532_handle, uint
         ESP_LOGD(TAG, "setting passive activation retries: %02X", max_retries);
     #endif
 
-    esp_err_t err = pn532_send_command_check_ack(pn532, command, sizeof(command), PN532_DEFAULT_TIMEOUT);
+    esp_err_t err = pn532_command(pn532, PN532_PRIORITY_NORMAL, command, sizeof(command), PN532_DEFAULT_TIMEOUT, NULL, 0);
     if(err != ESP_OK) {
         ESP_LOGE(TAG, "failed to set passive activation retries");
         return err;
@@ -209,38 +802,280 @@ esp_err_t pn532_set_passive_activation_retries(pn532_handle_t pn532_handle, uint
     return ESP_OK;
 }   
 
-esp_err_t pn532_read_passive_target_id(pn532_handle_t pn532_handle, uint8_t card_baud_rate, uint8_t* uid, size_t* uid_len) {
-    if(!pn532_handle || !uid || !uid_len) {
+static esp_err_t pn532_set_rf_profile_job(pn532_t* pn532, void* ctx) {
+    const pn532_rf_profile_t* profile = (const pn532_rf_profile_t*) ctx;
+
+    // the field goes last, so it only changes once the timings are in place
+    const uint8_t timings[] = {
+        PN532_COMMAND_RFCONFIGURATION,
+        0x02, // various timings
+        0x00, // RFU
+        profile->atr_res_timeout,
+        profile->retry_timeout,
+    };
+    const uint8_t retry_com[] = {
+        PN532_COMMAND_RFCONFIGURATION,
+        0x04, // MaxRtyCOM
+        profile->max_retry_com,
+    };
+    const uint8_t retries[] = {
+        PN532_COMMAND_RFCONFIGURATION,
+        0x05, // max retries
+        profile->max_retry_atr,
+        profile->max_retry_psl,
+        profile->max_retry_passive_activation,
+    };
+    const uint8_t field[] = {
+        PN532_COMMAND_RFCONFIGURATION,
+        0x01, // RF field
+        (profile->auto_rfca ? 0x02 : 0x00) | (profile->rf_field ? 0x01 : 0x00),
+    };
+
+    const struct {
+        const uint8_t* command;
+        size_t len;
+    } items[] = {
+        {timings, sizeof(timings)},
+        {retry_com, sizeof(retry_com)},
+        {retries, sizeof(retries)},
+        {field, sizeof(field)},
+    };
+    for(size_t i = 0; i < sizeof(items) / sizeof(items[0]); i++) {
+        esp_err_t err = pn532_rf_configuration(pn532, items[i].command, items[i].len);
+        if(err != ESP_OK) {
+            return err;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t pn532_set_rf_profile(pn532_handle_t pn532_handle, const pn532_rf_profile_t* profile) {
+    if(!pn532_handle || !profile) {
         return ESP_ERR_INVALID_ARG;
     }
 
     pn532_t* pn532 = (pn532_t*) pn532_handle;
 
+    esp_err_t err = pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_set_rf_profile_job, (void*) profile);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to set RF profile");
+        return err;
+    }
+
+    return ESP_OK;
+}
+
+// parses one 106 kbps type A target (Tg SENS_RES SEL_RES NFCIDLength NFCID1 [ATS]), with or without the Tg byte
+esp_err_t pn532_parse_target_106a(const uint8_t* data, size_t len, bool has_tg, pn532_target_t* target, size_t* consumed) {
+    size_t pos = 0;
+    memset(target, 0, sizeof(pn532_target_t));
+
+    if(has_tg) {
+        if(len < 1) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        target->tg = data[pos++];
+    }
+
+    if(len < pos + 4) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    target->atqa = (data[pos] << 8) | data[pos + 1];
+    target->sak = data[pos + 2];
+    target->uid_len = data[pos + 3];
+    pos += 4;
+
+    if(target->uid_len > PN532_MAX_UID_LEN || len < pos + target->uid_len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(target->uid, &data[pos], target->uid_len);
+    pos += target->uid_len;
+
+    // ISO/IEC 14443-4 compliant targets (SAK bit 5) append their ATS, first byte is its own length
+    if(target->sak & 0x20) {
+        if(len < pos + 1 || !data[pos] || len < pos + data[pos]) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        uint8_t ats_len = data[pos];
+        target->ats_len = (ats_len > PN532_MAX_ATS_LEN) ? PN532_MAX_ATS_LEN : ats_len;
+        memcpy(target->ats, &data[pos], target->ats_len);
+        pos += ats_len;
+    }
+
+    *consumed = pos;
+    return ESP_OK;
+}
+
+typedef struct {
+    uint8_t card_baud_rate;
+    uint8_t max_targets;
+    pn532_target_t* targets;
+    size_t* num_targets;
+} pn532_list_targets_job_t;
+
+static esp_err_t pn532_list_passive_targets_job(pn532_t* pn532, void* ctx) {
+    pn532_list_targets_job_t* job = (pn532_list_targets_job_t*) ctx;
+
     uint8_t command[] = {
         PN532_COMMAND_INLISTPASSIVETARGET,
-        PN532_MAX_CARDS,
-        card_baud_rate,
+        job->max_targets,
+        job->card_baud_rate,
     };
-    esp_err_t err = pn532_send_command_check_ack(pn532, command, sizeof(command), PN532_DEFAULT_TIMEOUT);
+    esp_err_t err = pn532_transceive(pn532, command, sizeof(command), PN532_ACK_TIMEOUT, PN532_DEFAULT_TIMEOUT, NULL);
     if(err != ESP_OK) {
-        ESP_LOGE(TAG, "failed to read passive target id");
         return err;
     }
 
-    uint8_t response[20];
-    size_t len = sizeof(response);
-    memcpy(response, (pn532->buffer + ACK_OFFSET), len);
+    // parsed in place: D5 4B NbTg TargetData...
+    const uint8_t* response = pn532->response_data;
+    if(pn532->response_data_len < 3 || response[1] != PN532_COMMAND_INLISTPASSIVETARGET + 1) {
+        ESP_LOGE(TAG, "failed to check passive target response");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    uint8_t num_targets = response[2];
+    if(num_targets > job->max_targets) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    const uint8_t* data = &response[3];
+    size_t len = pn532->response_data_len - 3;
+    for(size_t i = 0; i < num_targets; i++) {
+        size_t consumed = 0;
+        err = pn532_parse_target_106a(data, len, true, &job->targets[i], &consumed);
+        if(err != ESP_OK) {
+            ESP_LOGE(TAG, "malformed target data");
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        data += consumed;
+        len -= consumed;
+    }
+
+    *job->num_targets = num_targets;
+    return ESP_OK;
+}
+
+esp_err_t pn532_list_passive_targets(pn532_handle_t pn532_handle, uint8_t card_baud_rate, uint8_t max_targets, pn532_target_t* targets, size_t* num_targets) {
+    if(!pn532_handle || !targets || !num_targets || !max_targets || max_targets > PN532_MAX_TARGETS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(card_baud_rate != PN532_MIFARE_ISO14443A) {
+        ESP_LOGE(TAG, "only ISO14443A targets are supported");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    *num_targets = 0;
+    pn532_list_targets_job_t job = {
+        .card_baud_rate = card_baud_rate,
+        .max_targets = max_targets,
+        .targets = targets,
+        .num_targets = num_targets,
+    };
+    esp_err_t err = pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_list_passive_targets_job, &job);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to list passive targets");
+        return err;
+    }
 
-    if(!response[7]) {
+    if(!*num_targets) {
         ESP_LOGW(TAG, "no card detected");
         return ESP_ERR_NOT_FOUND;
     }
 
-    *uid_len = response[12];
-    for(size_t i = 0; i < *uid_len; i++) {
-        uid[i] = response[13 + i];
+    return ESP_OK;
+}
+
+// runs one exchange and returns the PN532 status byte (error code only) in status
+static esp_err_t pn532_status_exchange(pn532_t* pn532, const uint8_t* command, size_t command_len, uint8_t* status) {
+    esp_err_t err = pn532_transceive(pn532, command, command_len, PN532_ACK_TIMEOUT, PN532_PRESENT_TIMEOUT, NULL);
+    if(err != ESP_OK) {
+        return err;
     }
 
+    // D5 CC+1 Status ...
+    const uint8_t* response = pn532->response_data;
+    if(pn532->response_data_len < 3 || response[1] != command[0] + 1) {
+        ESP_LOGE(TAG, "failed to check response");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    *status = response[2] & 0x3F;
+    return ESP_OK;
+}
+
+typedef struct {
+    const pn532_target_t* target;
+    bool* present;
+} pn532_target_present_job_t;
+
+static esp_err_t pn532_target_present_job(pn532_t* pn532, void* ctx) {
+    pn532_target_present_job_t* job = (pn532_target_present_job_t*) ctx;
+    const pn532_target_t* target = job->target;
+
+    uint8_t status = 0;
+    esp_err_t err = ESP_OK;
+    if(target->ats_len) {
+        // ISO14443-4: attention request (R(NAK)), one exchange and the target stays active
+        err = pn532_status_exchange(pn532, (uint8_t[]) {PN532_COMMAND_DIAGNOSE, PN532_DIAGNOSE_ATTENTION}, 2, &status);
+    } else if(!target->sak) {
+        // Ultralight/NTAG: reading page 0 leaves the target active
+        err = pn532_status_exchange(pn532, (uint8_t[]) {PN532_COMMAND_INCOMMUNICATETHRU, PN532_ULTRALIGHT_READ, 0x00}, 3, &status);
+    } else {
+        // MIFARE Classic answers nothing without authentication, so it is halted and selected again by UID
+        err = pn532_status_exchange(pn532, (uint8_t[]) {PN532_COMMAND_INDESELECT, target->tg}, 2, &status);
+        if(err == ESP_OK) {
+            err = pn532_status_exchange(pn532, (uint8_t[]) {PN532_COMMAND_INSELECT, target->tg}, 2, &status);
+        }
+    }
+
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    *job->present = (status == 0x00);
+    return ESP_OK;
+}
+
+esp_err_t pn532_target_present(pn532_handle_t pn532_handle, const pn532_target_t* target, bool* present) {
+    if(!pn532_handle || !target || !present) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    *present = false;
+    pn532_target_present_job_t job = {
+        .target = target,
+        .present = present,
+    };
+    esp_err_t err = pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_target_present_job, &job);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to check target presence");
+        return err;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t pn532_read_passive_target_id(pn532_handle_t pn532_handle, uint8_t card_baud_rate, uint8_t* uid, size_t* uid_len) {
+    if(!pn532_handle || !uid || !uid_len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_target_t target;
+    size_t num_targets = 0;
+    esp_err_t err = pn532_list_passive_targets(pn532_handle, card_baud_rate, 1, &target, &num_targets);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    *uid_len = target.uid_len;
+    memcpy(uid, target.uid, target.uid_len);
+
     return ESP_OK;
 }
 
@@ -254,18 +1089,14 @@ esp_err_t pn532_read_gpio(pn532_handle_t pn532_handle, uint8_t* gpio_state) {
     uint8_t command[] = {
         PN532_COMMAND_READGPIO,
     };
-    size_t len = sizeof(command);
 
-    esp_err_t err = pn532_send_command_check_ack(pn532, command, len, PN532_DEFAULT_TIMEOUT);
+    uint8_t response[11];
+    esp_err_t err = pn532_command(pn532, PN532_PRIORITY_HIGH, command, sizeof(command), PN532_DEFAULT_TIMEOUT, response, sizeof(response));
     if(err != ESP_OK) {
         ESP_LOGE(TAG, "failed to read GPIO");
         return err;
     }
 
-    uint8_t response[11];
-    len = sizeof(response);
-    memcpy(response, (pn532->buffer + ACK_OFFSET), len);
-
     gpio_state[0] = response[7]; // P3
     gpio_state[1] = response[8]; // P7
     gpio_state[2] = response[9]; // I0
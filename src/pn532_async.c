@@ -0,0 +1,253 @@
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+
+#define PN532_ASYNC_STACK_SIZE 4096
+#define PN532_ASYNC_PRIORITY 5
+#define PN532_ASYNC_QUEUE_LEN 8
+
+#define PN532_ASYNC_ACK_TIMEOUT 30
+
+static const char* TAG = "pn532";
+
+typedef struct {
+    // sync requests run a job and signal done
+    pn532_job_t job;
+    void* ctx;
+    esp_err_t* err;
+    SemaphoreHandle_t done;
+    // submitted commands carry their own copy and complete through the callback
+    pn532_command_cb_t callback;
+    void* arg;
+    uint32_t timeout;
+    size_t command_len;
+    uint8_t command[PN532_ASYNC_MAX_COMMAND_LEN];
+} pn532_request_t;
+
+extern esp_err_t pn532_transceive(pn532_t* pn532, const uint8_t* command, size_t command_len, uint32_t ack_timeout, uint32_t response_timeout, pn532_latency_t* latency);
+
+static void pn532_async_process(pn532_t* pn532, pn532_request_t* request) {
+    if(xSemaphoreTake(pn532->mutex, portMAX_DELAY) != pdTRUE) {
+        return;
+    }
+
+    if(request->job) {
+        *request->err = request->job(pn532, request->ctx);
+        xSemaphoreGive(pn532->mutex);
+        xSemaphoreGive(request->done);
+        return;
+    }
+
+    esp_err_t err = pn532_transceive(pn532, request->command, request->command_len, PN532_ASYNC_ACK_TIMEOUT, request->timeout, NULL);
+    if(request->callback) {
+        // the response stays valid until the mutex is released
+        request->callback(pn532, err, (err == ESP_OK) ? pn532->buffer + ACK_OFFSET : NULL, (err == ESP_OK) ? pn532->response_len : 0, request->arg);
+    }
+
+    xSemaphoreGive(pn532->mutex);
+}
+
+// completes a request that will never run, so no waiter is left behind
+static void pn532_async_cancel(pn532_t* pn532, pn532_request_t* request) {
+    if(request->job) {
+        *request->err = ESP_ERR_INVALID_STATE;
+        xSemaphoreGive(request->done);
+        return;
+    }
+
+    if(request->callback) {
+        request->callback(pn532, ESP_ERR_INVALID_STATE, NULL, 0, request->arg);
+    }
+}
+
+static void pn532_async_task(void* pvParameters) {
+    pn532_t* pn532 = (pn532_t*) pvParameters;
+
+    pn532_request_t request;
+    while(!pn532->async.stopping) {
+        (void) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // high priority queue is checked again after every request, stopping after the current one; the queues are
+        // rescanned rather than trusting the notification count, which an IRQ wait on a shared index can consume
+        while(!pn532->async.stopping && (xQueueReceive(pn532->async.queues[PN532_PRIORITY_HIGH], &request, 0) == pdTRUE ||
+                                         xQueueReceive(pn532->async.queues[PN532_PRIORITY_NORMAL], &request, 0) == pdTRUE)) {
+            pn532_async_process(pn532, &request);
+        }
+    }
+
+    // anything still queued, including requests that raced past the stopping flag
+    for(size_t i = 0; i < PN532_PRIORITY_MAX; i++) {
+        while(xQueueReceive(pn532->async.queues[i], &request, 0) == pdTRUE) {
+            pn532_async_cancel(pn532, &request);
+        }
+    }
+
+    xSemaphoreGive(pn532->async.stopped);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t pn532_async_enqueue(pn532_t* pn532, pn532_priority_t priority, const pn532_request_t* request, TickType_t timeout) {
+    if(xQueueSend(pn532->async.queues[priority], request, timeout) != pdTRUE) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    xTaskNotifyGive(pn532->async.task);
+    return ESP_OK;
+}
+
+esp_err_t pn532_run(pn532_t* pn532, pn532_priority_t priority, pn532_job_t job, void* ctx) {
+    if(!pn532->async.task) {
+        atomic_fetch_add(&pn532->async.waiting, 1);
+        BaseType_t taken = xSemaphoreTake(pn532->mutex, pdMS_TO_TICKS(1000));
+        atomic_fetch_sub(&pn532->async.waiting, 1);
+        if(taken != pdTRUE) {
+            ESP_LOGE(TAG, "failed to take mutex");
+            return ESP_FAIL;
+        }
+
+        esp_err_t err = job(pn532, ctx);
+
+        xSemaphoreGive(pn532->mutex);
+        return err;
+    }
+
+    if(xTaskGetCurrentTaskHandle() == pn532->async.task) {
+        // already on the worker (e.g. from a callback), the mutex is held
+        return job(pn532, ctx);
+    }
+
+    if(pn532->async.stopping) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    StaticSemaphore_t done_buffer;
+    esp_err_t err = ESP_FAIL;
+    pn532_request_t request = {
+        .job = job,
+        .ctx = ctx,
+        .err = &err,
+        .done = xSemaphoreCreateBinaryStatic(&done_buffer),
+    };
+
+    esp_err_t queue_err = pn532_async_enqueue(pn532, priority, &request, portMAX_DELAY);
+    if(queue_err != ESP_OK) {
+        vSemaphoreDelete(request.done);
+        return queue_err;
+    }
+
+    (void) xSemaphoreTake(request.done, portMAX_DELAY);
+    vSemaphoreDelete(request.done);
+    return err;
+}
+
+// true if another request waits for the handle, long jobs (e.g. autopoll) check it to give the handle up
+bool pn532_run_pending(pn532_t* pn532) {
+    if(!pn532->async.task) {
+        return atomic_load(&pn532->async.waiting) > 0;
+    }
+
+    for(size_t i = 0; i < PN532_PRIORITY_MAX; i++) {
+        if(uxQueueMessagesWaiting(pn532->async.queues[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t pn532_submit_command(pn532_handle_t pn532_handle, const uint8_t* command, size_t command_len, uint32_t timeout, pn532_priority_t priority, pn532_command_cb_t callback, void* arg) {
+    if(!pn532_handle || !command || !command_len || command_len > PN532_ASYNC_MAX_COMMAND_LEN || priority >= PN532_PRIORITY_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    if(!pn532->async.task) {
+        ESP_LOGE(TAG, "async mode not enabled");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if(pn532->async.stopping) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    pn532_request_t request = {
+        .callback = callback,
+        .arg = arg,
+        .timeout = timeout,
+        .command_len = command_len,
+    };
+    memcpy(request.command, command, command_len);
+
+    esp_err_t err = pn532_async_enqueue(pn532, priority, &request, 0);
+    if(err != ESP_OK) {
+        ESP_LOGW(TAG, "request queue full");
+    }
+
+    return err;
+}
+
+esp_err_t pn532_async_start(pn532_t* pn532, const pn532_async_config_t* config) {
+    size_t queue_len = config->queue_len ? config->queue_len : PN532_ASYNC_QUEUE_LEN;
+    uint32_t stack_size = config->task_stack_size ? config->task_stack_size : PN532_ASYNC_STACK_SIZE;
+    UBaseType_t priority = config->task_priority ? config->task_priority : PN532_ASYNC_PRIORITY;
+
+    for(size_t i = 0; i < PN532_PRIORITY_MAX; i++) {
+        pn532->async.queues[i] = xQueueCreate(queue_len, sizeof(pn532_request_t));
+        if(!pn532->async.queues[i]) {
+            ESP_LOGE(TAG, "failed to create request queue");
+            goto ERR;
+        }
+    }
+
+    pn532->async.stopped = xSemaphoreCreateBinary();
+    if(!pn532->async.stopped) {
+        ESP_LOGE(TAG, "failed to create semaphore");
+        goto ERR;
+    }
+
+    BaseType_t core = config->task_pinned ? config->task_core : tskNO_AFFINITY;
+    if(xTaskCreatePinnedToCore(pn532_async_task, "pn532", stack_size, pn532, priority, &pn532->async.task, core) != pdPASS) {
+        ESP_LOGE(TAG, "failed to create worker task");
+        pn532->async.task = NULL;
+        goto ERR;
+    }
+
+    return ESP_OK;
+
+ERR:
+    if(pn532->async.stopped) {
+        vSemaphoreDelete(pn532->async.stopped);
+        pn532->async.stopped = NULL;
+    }
+    for(size_t i = 0; i < PN532_PRIORITY_MAX; i++) {
+        if(pn532->async.queues[i]) {
+            vQueueDelete(pn532->async.queues[i]);
+            pn532->async.queues[i] = NULL;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void pn532_async_stop(pn532_t* pn532) {
+    if(!pn532->async.task) {
+        return;
+    }
+
+    // the worker stops after the request it is running, whatever is still queued fails with ESP_ERR_INVALID_STATE
+    pn532->async.stopping = true;
+    xTaskNotifyGive(pn532->async.task);
+
+    (void) xSemaphoreTake(pn532->async.stopped, portMAX_DELAY);
+    pn532->async.task = NULL;
+    pn532->async.stopping = false;
+
+    vSemaphoreDelete(pn532->async.stopped);
+    pn532->async.stopped = NULL;
+    for(size_t i = 0; i < PN532_PRIORITY_MAX; i++) {
+        vQueueDelete(pn532->async.queues[i]);
+        pn532->async.queues[i] = NULL;
+    }
+}
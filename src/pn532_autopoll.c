@@ -0,0 +1,282 @@
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define PN532_AUTOPOLL_STACK_SIZE 4096
+#define PN532_AUTOPOLL_PRIORITY 5
+#define PN532_AUTOPOLL_QUEUE_LEN 8
+
+#define PN532_AUTOPOLL_ACK_TIMEOUT 30
+#define PN532_AUTOPOLL_SLICE 100 // how often a running poll checks for a stop request or another request
+#define PN532_AUTOPOLL_PERIOD_MS 150
+#define PN532_AUTOPOLL_MARGIN 1000
+
+static const char* TAG = "pn532";
+
+extern esp_err_t pn532_run(pn532_t* pn532, pn532_priority_t priority, pn532_job_t job, void* ctx);
+extern bool pn532_run_pending(pn532_t* pn532);
+extern esp_err_t pn532_write_command_check_ack(pn532_t* pn532, const uint8_t* command, size_t command_len, const uint8_t* data, size_t data_len, uint32_t ack_timeout, uint32_t* ack_latency_us);
+extern esp_err_t pn532_read_response(pn532_t* pn532, uint32_t timeout);
+extern void pn532_stats_record_response(pn532_t* pn532, size_t bytes_in, esp_err_t err);
+extern esp_err_t pn532_parse_target_106a(const uint8_t* data, size_t len, bool has_tg, pn532_target_t* target, size_t* consumed);
+extern void pn532_uid_cache_clear(pn532_t* pn532);
+extern bool pn532_uid_cache_seen(pn532_t* pn532, uint8_t type, const pn532_target_t* target, int64_t now);
+extern bool pn532_uid_cache_next_departed(pn532_t* pn532, size_t* cursor, int64_t seen_before, pn532_scan_event_t* event);
+
+static bool pn532_autopoll_type_supported(uint8_t type) {
+    return type == PN532_AUTOPOLL_GENERIC_106A || type == PN532_AUTOPOLL_MIFARE || type == PN532_AUTOPOLL_ISO14443_4A;
+}
+
+static void pn532_autopoll_send(pn532_t* pn532, const pn532_scan_event_t* event) {
+    if(xQueueSend(pn532->autopoll.events, event, 0) != pdTRUE) {
+        atomic_fetch_add(&pn532->autopoll.dropped, 1);
+    } else {
+        atomic_fetch_add(&pn532->autopoll.posted, 1);
+    }
+}
+
+// reports cached UIDs that were not seen for dedup_ttl_ms
+static void pn532_autopoll_expire(pn532_t* pn532) {
+    uint32_t ttl_ms = pn532->autopoll.config.dedup_ttl_ms;
+    if(!ttl_ms) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    size_t cursor = 0;
+    pn532_scan_event_t event;
+    while(pn532_uid_cache_next_departed(pn532, &cursor, now - 1000LL * ttl_ms, &event)) {
+        event.reader = pn532->autopoll.reader;
+        event.timestamp_us = now;
+        pn532_autopoll_send(pn532, &event);
+    }
+}
+
+static void pn532_autopoll_post(pn532_t* pn532) {
+    // D5 61 NbTg [Type Len TargetData]...
+    const uint8_t* response = pn532->response_data;
+    if(pn532->response_data_len < 3 || response[1] != PN532_COMMAND_INAUTOPOLL + 1) {
+        ESP_LOGE(TAG, "failed to check autopoll response");
+        return;
+    }
+
+    const uint8_t* data = &response[3];
+    size_t len = pn532->response_data_len - 3;
+    int64_t now = esp_timer_get_time();
+    for(size_t i = 0; i < response[2]; i++) {
+        if(len < 2 || len - 2 < data[1]) {
+            ESP_LOGE(TAG, "malformed autopoll target");
+            return;
+        }
+
+        pn532_scan_event_t event = {
+            .kind = PN532_SCAN_DETECTED,
+            .type = data[0],
+            .reader = pn532->autopoll.reader,
+            .timestamp_us = now,
+        };
+        size_t consumed = 0;
+        if(pn532_autopoll_type_supported(event.type) && pn532_parse_target_106a(&data[2], data[1], true, &event.target, &consumed) == ESP_OK) {
+            if(!pn532->autopoll.config.dedup_ttl_ms) {
+                pn532_autopoll_send(pn532, &event);
+            } else if(pn532_uid_cache_seen(pn532, event.type, &event.target, now)) {
+                event.kind = PN532_SCAN_ARRIVED;
+                pn532_autopoll_send(pn532, &event);
+            }
+        }
+
+        len -= 2 + data[1];
+        data += 2 + data[1];
+    }
+}
+
+static esp_err_t pn532_autopoll_job(pn532_t* pn532, void* ctx) {
+    const pn532_autopoll_config_t* config = &pn532->autopoll.config;
+
+    uint8_t command[3 + PN532_AUTOPOLL_MAX_TYPES] = {
+        PN532_COMMAND_INAUTOPOLL,
+        config->poll_count,
+        config->period,
+    };
+    memcpy(&command[3], config->types, config->num_types);
+
+    esp_err_t err = pn532_write_command_check_ack(pn532, command, 3 + config->num_types, NULL, 0, PN532_AUTOPOLL_ACK_TIMEOUT, NULL);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    // a full cycle polls every type poll_count times, endless polling (0xFF) has no deadline
+    bool endless = config->poll_count == 0xFF;
+    int64_t deadline = esp_timer_get_time() + 1000LL * (config->poll_count * config->num_types * config->period * PN532_AUTOPOLL_PERIOD_MS + PN532_AUTOPOLL_MARGIN);
+    while(true) {
+        err = pn532_read_response(pn532, PN532_AUTOPOLL_SLICE);
+        if(err != ESP_ERR_TIMEOUT) {
+            break;
+        }
+        pn532_autopoll_expire(pn532);
+
+        // another request waiting for the handle ends the cycle early, the scan task issues the next one after it
+        bool yield = pn532_run_pending(pn532);
+        if(pn532->autopoll.stop || yield || (!endless && esp_timer_get_time() > deadline)) {
+            // an ack from the host aborts the running command
+            (void) pn532->write_raw(pn532, (const uint8_t[]) {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00}, 6);
+            if(pn532->autopoll.stop) {
+                return ESP_OK;
+            }
+            if(yield) {
+                return ESP_ERR_NOT_FINISHED;
+            }
+            pn532_stats_record_response(pn532, 0, ESP_ERR_TIMEOUT);
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    pn532_autopoll_post(pn532);
+    pn532_autopoll_expire(pn532);
+    return ESP_OK;
+}
+
+static void pn532_autopoll_task(void* pvParameters) {
+    pn532_t* pn532 = (pn532_t*) pvParameters;
+
+    while(!pn532->autopoll.stop) {
+        esp_err_t err = pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_autopoll_job, NULL);
+        if(err == ESP_ERR_NOT_FINISHED) {
+            // the mutex does not hand itself over, step aside so the waiting task gets it
+            vTaskDelay(1);
+        } else if(err != ESP_OK && err != ESP_ERR_TIMEOUT) {
+            ESP_LOGE(TAG, "autopoll failed: %d", err);
+            vTaskDelay(pdMS_TO_TICKS(PN532_AUTOPOLL_SLICE)); // don't spin on a dead link
+        }
+    }
+
+    xSemaphoreGive(pn532->autopoll.stopped);
+    vTaskDelete(NULL);
+}
+
+esp_err_t pn532_autopoll_check_config(const pn532_autopoll_config_t* config) {
+    if(!config->num_types || config->num_types > PN532_AUTOPOLL_MAX_TYPES || !config->poll_count || !config->period || config->period > 0x0F) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for(size_t i = 0; i < config->num_types; i++) {
+        if(!pn532_autopoll_type_supported(config->types[i])) {
+            ESP_LOGE(TAG, "unsupported autopoll type: %02X", config->types[i]);
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+    }
+
+    if(config->dedup_ttl_ms && PN532_UID_CACHE_SIZE == 0) {
+        ESP_LOGE(TAG, "uid cache disabled (CONFIG_PN532_UID_CACHE_SIZE)");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    return ESP_OK;
+}
+
+// starts the scan task, events is the queue of a reader group or NULL for a queue owned by the handle
+esp_err_t pn532_autopoll_launch(pn532_t* pn532, const pn532_autopoll_config_t* config, QueueHandle_t events, uint8_t reader) {
+    if(pn532->autopoll.task) {
+        ESP_LOGE(TAG, "autopoll already running");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    pn532->autopoll.config = *config;
+    pn532->autopoll.stop = false;
+    atomic_store(&pn532->autopoll.posted, 0);
+    atomic_store(&pn532->autopoll.dropped, 0);
+    pn532->autopoll.reader = reader;
+    pn532->autopoll.shared = events != NULL;
+    pn532_uid_cache_clear(pn532);
+
+    pn532->autopoll.events = events ? events : xQueueCreate(config->queue_len ? config->queue_len : PN532_AUTOPOLL_QUEUE_LEN, sizeof(pn532_scan_event_t));
+    if(!pn532->autopoll.events) {
+        ESP_LOGE(TAG, "failed to create event queue");
+        return ESP_ERR_NO_MEM;
+    }
+
+    pn532->autopoll.stopped = xSemaphoreCreateBinary();
+    if(!pn532->autopoll.stopped) {
+        ESP_LOGE(TAG, "failed to create semaphore");
+        goto ERR;
+    }
+
+    uint32_t stack_size = config->task_stack_size ? config->task_stack_size : PN532_AUTOPOLL_STACK_SIZE;
+    UBaseType_t priority = config->task_priority ? config->task_priority : PN532_AUTOPOLL_PRIORITY;
+    BaseType_t core = config->task_pinned ? config->task_core : tskNO_AFFINITY;
+    if(xTaskCreatePinnedToCore(pn532_autopoll_task, "pn532_autopoll", stack_size, pn532, priority, &pn532->autopoll.task, core) != pdPASS) {
+        ESP_LOGE(TAG, "failed to create autopoll task");
+        pn532->autopoll.task = NULL;
+        vSemaphoreDelete(pn532->autopoll.stopped);
+        pn532->autopoll.stopped = NULL;
+        goto ERR;
+    }
+
+    return ESP_OK;
+
+ERR:
+    if(!pn532->autopoll.shared) {
+        vQueueDelete(pn532->autopoll.events);
+    }
+    pn532->autopoll.events = NULL;
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t pn532_autopoll_start(pn532_handle_t pn532_handle, const pn532_autopoll_config_t* config, QueueHandle_t* events) {
+    if(!pn532_handle || !config || !events) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = pn532_autopoll_check_config(config);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    err = pn532_autopoll_launch(pn532, config, NULL, 0);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    *events = pn532->autopoll.events;
+    return ESP_OK;
+}
+
+esp_err_t pn532_autopoll_stop(pn532_handle_t pn532_handle) {
+    if(!pn532_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    if(!pn532->autopoll.task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    pn532->autopoll.stop = true;
+    (void) xSemaphoreTake(pn532->autopoll.stopped, portMAX_DELAY);
+    pn532->autopoll.task = NULL;
+
+    unsigned dropped = atomic_load(&pn532->autopoll.dropped);
+    if(dropped) {
+        ESP_LOGW(TAG, "autopoll dropped %u events", dropped);
+    }
+
+    vSemaphoreDelete(pn532->autopoll.stopped);
+    if(!pn532->autopoll.shared) {
+        vQueueDelete(pn532->autopoll.events);
+    }
+    pn532->autopoll.stopped = NULL;
+    pn532->autopoll.events = NULL;
+
+    return ESP_OK;
+}
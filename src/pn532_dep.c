@@ -0,0 +1,318 @@
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define PN532_DEP_ACK_TIMEOUT 30
+#define PN532_DEP_JUMP_TIMEOUT 1000
+#define PN532_DEP_RELEASE_TIMEOUT 100
+#define PN532_DEP_STATUS_MI 0x40 // more information, chained by the sender
+#define PN532_DEP_STATUS_ERROR 0x3F
+#define PN532_DEP_MAX_GI 48
+
+static const char* TAG = "pn532";
+
+extern esp_err_t pn532_run(pn532_t* pn532, pn532_priority_t priority, pn532_job_t job, void* ctx);
+extern esp_err_t pn532_transceive_data(pn532_t* pn532, const uint8_t* command, size_t command_len, const uint8_t* data, size_t data_len, uint32_t ack_timeout, uint32_t response_timeout, pn532_latency_t* latency);
+extern esp_err_t pn532_write_command_check_ack(pn532_t* pn532, const uint8_t* command, size_t command_len, const uint8_t* data, size_t data_len, uint32_t ack_timeout, uint32_t* ack_latency_us);
+extern esp_err_t pn532_read_response(pn532_t* pn532, uint32_t timeout);
+extern void pn532_stats_record_response(pn532_t* pn532, size_t bytes_in, esp_err_t err);
+
+typedef struct {
+    const pn532_dep_config_t* config;
+    pn532_dep_session_t* session;
+} pn532_dep_open_job_t;
+
+static esp_err_t pn532_dep_open_job(pn532_t* pn532, void* ctx) {
+    pn532_dep_open_job_t* job = (pn532_dep_open_job_t*) ctx;
+    const pn532_dep_config_t* config = job->config;
+    pn532_dep_session_t* session = job->session;
+
+    // ActPass BR Next [PassiveInitiatorData] [NFCID3i] [Gi]
+    uint8_t data[3 + 5 + 10 + PN532_DEP_MAX_GI];
+    size_t len = 3;
+    data[0] = config->active ? 0x01 : 0x00;
+    data[1] = config->baud_rate;
+    data[2] = 0x00;
+
+    // passive 212/424 kbps starts with a FeliCa polling request (any system code, no request code, one slot)
+    if(!config->active && config->baud_rate != PN532_DEP_106) {
+        static const uint8_t polling[] = {0x00, 0xFF, 0xFF, 0x00, 0x00};
+        memcpy(&data[len], polling, sizeof(polling));
+        len += sizeof(polling);
+        data[2] |= 0x01;
+    }
+    if(config->general_bytes_len) {
+        memcpy(&data[len], config->general_bytes, config->general_bytes_len);
+        len += config->general_bytes_len;
+        data[2] |= 0x04;
+    }
+
+    uint8_t command[] = {PN532_COMMAND_INJUMPFORDEP};
+    esp_err_t err = pn532_transceive_data(pn532, command, sizeof(command), data, len, PN532_DEP_ACK_TIMEOUT, PN532_DEP_JUMP_TIMEOUT, NULL);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    // D5 57 Status Tg NFCID3t(10) DIDt BSt BRt TO PPt [Gt]
+    const uint8_t* response = pn532->response_data;
+    if(pn532->response_data_len < 3 || response[1] != PN532_COMMAND_INJUMPFORDEP + 1) {
+        ESP_LOGE(TAG, "failed to check jump for DEP response");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    if(response[2] & PN532_DEP_STATUS_ERROR) {
+        // no DEP target in the field
+        return ESP_ERR_NOT_FOUND;
+    }
+    if(pn532->response_data_len < 19) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    session->tg = response[3];
+    memcpy(session->nfcid3t, &response[4], sizeof(session->nfcid3t));
+
+    size_t gt_len = pn532->response_data_len - 19;
+    if(gt_len > sizeof(session->general_bytes)) {
+        gt_len = sizeof(session->general_bytes);
+    }
+    memcpy(session->general_bytes, &response[19], gt_len);
+    session->general_bytes_len = gt_len;
+
+    return ESP_OK;
+}
+
+esp_err_t pn532_dep_open(pn532_handle_t pn532_handle, const pn532_dep_config_t* config, pn532_dep_session_t* session) {
+    if(!pn532_handle || !config || !session || config->baud_rate > PN532_DEP_424) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(config->general_bytes_len > PN532_DEP_MAX_GI || (config->general_bytes_len && !config->general_bytes)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    memset(session, 0, sizeof(pn532_dep_session_t));
+    session->pn532 = pn532_handle;
+    session->timeout = config->timeout ? config->timeout : PN532_DEP_JUMP_TIMEOUT;
+
+    pn532_dep_open_job_t job = {
+        .config = config,
+        .session = session,
+    };
+    esp_err_t err = pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_dep_open_job, &job);
+    if(err != ESP_OK) {
+        if(err != ESP_ERR_NOT_FOUND) {
+            ESP_LOGE(TAG, "failed to open DEP session");
+        }
+        return err;
+    }
+
+    return ESP_OK;
+}
+
+typedef struct {
+    pn532_dep_session_t* session;
+    const uint8_t* tx;
+    size_t tx_len;
+    uint8_t* rx;
+    size_t rx_size;
+    size_t* rx_len;
+} pn532_dep_exchange_job_t;
+
+// sends one InDataExchange, prepare (can be NULL) runs on the host while the PN532 is on air
+static esp_err_t pn532_dep_chunk(pn532_t* pn532, pn532_dep_session_t* session, const uint8_t* command, const uint8_t* data, size_t len, void (*prepare)(void* arg), void* arg) {
+    esp_err_t err = pn532_write_command_check_ack(pn532, command, 2, data, len, PN532_DEP_ACK_TIMEOUT, NULL);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    if(prepare) {
+        prepare(arg);
+    }
+
+    err = pn532_read_response(pn532, session->timeout);
+    if(err != ESP_OK) {
+        if(err == ESP_ERR_TIMEOUT) {
+            pn532_stats_record_response(pn532, 0, err);
+        }
+        return err;
+    }
+
+    // D5 41 Status DataIn
+    const uint8_t* response = pn532->response_data;
+    if(pn532->response_data_len < 3 || response[1] != PN532_COMMAND_INDATAEXCHANGE + 1) {
+        ESP_LOGE(TAG, "failed to check data exchange response");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    if(response[2] & PN532_DEP_STATUS_ERROR) {
+        ESP_LOGE(TAG, "DEP error: %02X", response[2] & PN532_DEP_STATUS_ERROR);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    session->stats.chunks++;
+    return ESP_OK;
+}
+
+typedef struct {
+    uint8_t* dst;
+    const uint8_t* src;
+    size_t len;
+} pn532_dep_copy_t;
+
+static void pn532_dep_copy(void* arg) {
+    pn532_dep_copy_t* copy = (pn532_dep_copy_t*) arg;
+    memcpy(copy->dst, copy->src, copy->len);
+}
+
+static esp_err_t pn532_dep_exchange_job(pn532_t* pn532, void* ctx) {
+    pn532_dep_exchange_job_t* job = (pn532_dep_exchange_job_t*) ctx;
+    pn532_dep_session_t* session = job->session;
+
+    int64_t started_at = esp_timer_get_time();
+
+    // send, chained with MI; chunks leave straight from the caller's buffer, an empty send polls the target
+    size_t sent = 0;
+    while(true) {
+        size_t chunk = job->tx_len - sent;
+        if(chunk > PN532_DEP_MAX_CHUNK) {
+            chunk = PN532_DEP_MAX_CHUNK;
+        }
+        bool more = sent + chunk < job->tx_len;
+
+        uint8_t command[] = {PN532_COMMAND_INDATAEXCHANGE, session->tg | (more ? PN532_DEP_STATUS_MI : 0)};
+        esp_err_t err = pn532_dep_chunk(pn532, session, command, job->tx ? job->tx + sent : NULL, chunk, NULL, NULL);
+        if(err != ESP_OK) {
+            return err;
+        }
+        sent += chunk;
+
+        if(!more) {
+            break;
+        }
+    }
+    session->stats.bytes_sent += sent;
+
+    // receive, the reply starts in the response to the last chunk sent
+    size_t received = 0;
+    while(true) {
+        const uint8_t* data = &pn532->response_data[3];
+        size_t len = pn532->response_data_len - 3;
+        bool more = pn532->response_data[2] & PN532_DEP_STATUS_MI;
+
+        if(job->rx && received + len > job->rx_size) {
+            ESP_LOGE(TAG, "DEP reply too long");
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        if(!more) {
+            if(job->rx) {
+                memcpy(&job->rx[received], data, len);
+            }
+            received += len;
+            break;
+        }
+
+        // this part stays in the handle buffer (the ack lands before it) and is copied out while the next one is on air
+        pn532_dep_copy_t copy = {
+            .dst = job->rx ? &job->rx[received] : NULL,
+            .src = data,
+            .len = len,
+        };
+        uint8_t command[] = {PN532_COMMAND_INDATAEXCHANGE, session->tg};
+        esp_err_t err = pn532_dep_chunk(pn532, session, command, NULL, 0, job->rx ? pn532_dep_copy : NULL, &copy);
+        if(err != ESP_OK) {
+            return err;
+        }
+        received += len;
+    }
+    session->stats.bytes_received += received;
+
+    if(job->rx_len) {
+        *job->rx_len = received;
+    }
+
+    session->stats.transfer_us += esp_timer_get_time() - started_at;
+    if(session->stats.transfer_us) {
+        session->stats.bytes_per_second = (uint32_t) (((session->stats.bytes_sent + session->stats.bytes_received) * 1000000ULL) / session->stats.transfer_us);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t pn532_dep_transceive(pn532_dep_session_t* session, const uint8_t* tx, size_t tx_len, uint8_t* rx, size_t rx_size, size_t* rx_len) {
+    if(!session || !session->pn532 || (tx_len && !tx) || (rx_size && !rx)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_dep_exchange_job_t job = {
+        .session = session,
+        .tx = tx,
+        .tx_len = tx_len,
+        .rx = rx_size ? rx : NULL,
+        .rx_size = rx_size,
+        .rx_len = rx_len,
+    };
+    esp_err_t err = pn532_run((pn532_t*) session->pn532, PN532_PRIORITY_NORMAL, pn532_dep_exchange_job, &job);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "DEP exchange failed");
+        return err;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t pn532_dep_send(pn532_dep_session_t* session, const uint8_t* data, size_t len) {
+    if(!data || !len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return pn532_dep_transceive(session, data, len, NULL, 0, NULL);
+}
+
+esp_err_t pn532_dep_recv(pn532_dep_session_t* session, uint8_t* data, size_t size, size_t* len) {
+    if(!data || !size || !len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return pn532_dep_transceive(session, NULL, 0, data, size, len);
+}
+
+static esp_err_t pn532_dep_close_job(pn532_t* pn532, void* ctx) {
+    pn532_dep_session_t* session = (pn532_dep_session_t*) ctx;
+
+    uint8_t command[] = {
+        PN532_COMMAND_INRELEASE,
+        session->tg,
+    };
+    esp_err_t err = pn532_transceive_data(pn532, command, sizeof(command), NULL, 0, PN532_DEP_ACK_TIMEOUT, PN532_DEP_RELEASE_TIMEOUT, NULL);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    // D5 53 Status
+    if(pn532->response_data_len < 3 || pn532->response_data[1] != PN532_COMMAND_INRELEASE + 1) {
+        ESP_LOGE(TAG, "failed to check release response");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t pn532_dep_close(pn532_dep_session_t* session) {
+    if(!session || !session->pn532) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = pn532_run((pn532_t*) session->pn532, PN532_PRIORITY_NORMAL, pn532_dep_close_job, session);
+    session->pn532 = NULL;
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to release DEP target");
+        return err;
+    }
+
+    return ESP_OK;
+}
@@ -0,0 +1,231 @@
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+
+#define PN532_GROUP_QUEUE_LEN 8 // per reader
+
+static const char* TAG = "pn532";
+
+typedef struct pn532_group_t {
+    pn532_handle_t readers[PN532_GROUP_MAX_READERS];
+    size_t num_readers;
+    BaseType_t task_core[PN532_GROUP_MAX_READERS];
+    bool task_pinned[PN532_GROUP_MAX_READERS];
+    pn532_autopoll_config_t autopoll;
+    QueueHandle_t events; // NULL when stopped
+} pn532_group_t;
+
+extern esp_err_t pn532_autopoll_check_config(const pn532_autopoll_config_t* config);
+extern esp_err_t pn532_autopoll_launch(pn532_t* pn532, const pn532_autopoll_config_t* config, QueueHandle_t events, uint8_t reader);
+
+esp_err_t pn532_group_init(pn532_group_handle_t* group_handle, const pn532_group_config_t* config) {
+    if(!group_handle || !config || !config->num_readers || config->num_readers > PN532_GROUP_MAX_READERS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = pn532_autopoll_check_config(&config->autopoll);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    pn532_group_t* group = (pn532_group_t*) calloc(1, sizeof(pn532_group_t));
+    if(!group) {
+        return ESP_ERR_NO_MEM;
+    }
+    group->autopoll = config->autopoll;
+
+    for(size_t i = 0; i < config->num_readers; i++) {
+        err = pn532_init(&group->readers[i], &config->readers[i].config);
+        if(err != ESP_OK) {
+            ESP_LOGE(TAG, "failed to init reader %d", (int) i);
+            goto ERR;
+        }
+        group->task_core[i] = config->readers[i].task_core;
+        group->task_pinned[i] = config->readers[i].task_pinned;
+        group->num_readers++;
+    }
+
+    *group_handle = group;
+    return ESP_OK;
+
+ERR:
+    for(size_t i = 0; i < group->num_readers; i++) {
+        pn532_free(group->readers[i]);
+    }
+    free(group);
+    return err;
+}
+
+esp_err_t pn532_group_free(pn532_group_handle_t group_handle) {
+    if(!group_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_group_t* group = (pn532_group_t*) group_handle;
+
+    (void) pn532_group_stop(group);
+    for(size_t i = 0; i < group->num_readers; i++) {
+        pn532_free(group->readers[i]);
+    }
+    free(group);
+
+    return ESP_OK;
+}
+
+static void pn532_group_halt(pn532_group_t* group, size_t num_running) {
+    for(size_t i = 0; i < num_running; i++) {
+        (void) pn532_autopoll_stop(group->readers[i]);
+    }
+    vQueueDelete(group->events);
+    group->events = NULL;
+}
+
+esp_err_t pn532_group_start(pn532_group_handle_t group_handle, QueueHandle_t* events) {
+    if(!group_handle || !events) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_group_t* group = (pn532_group_t*) group_handle;
+
+    if(group->events) {
+        ESP_LOGE(TAG, "group already running");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // one queue for every reader keeps detections in the order they were reported
+    size_t queue_len = (group->autopoll.queue_len ? group->autopoll.queue_len : PN532_GROUP_QUEUE_LEN) * group->num_readers;
+    group->events = xQueueCreate(queue_len, sizeof(pn532_scan_event_t));
+    if(!group->events) {
+        ESP_LOGE(TAG, "failed to create event queue");
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = ESP_OK;
+    for(size_t i = 0; i < group->num_readers; i++) {
+        err = pn532_start(group->readers[i]);
+        if(err == ESP_OK) {
+            err = pn532_SAM_configuration(group->readers[i]);
+        }
+        if(err != ESP_OK) {
+            ESP_LOGE(TAG, "failed to bring up reader %d", (int) i);
+            pn532_group_halt(group, i);
+            return err;
+        }
+
+        pn532_autopoll_config_t autopoll = group->autopoll;
+        autopoll.task_core = group->task_core[i];
+        autopoll.task_pinned = group->task_pinned[i];
+        err = pn532_autopoll_launch(group->readers[i], &autopoll, group->events, i);
+        if(err != ESP_OK) {
+            pn532_group_halt(group, i);
+            return err;
+        }
+    }
+
+    *events = group->events;
+    return ESP_OK;
+}
+
+esp_err_t pn532_group_stop(pn532_group_handle_t group_handle) {
+    if(!group_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_group_t* group = (pn532_group_t*) group_handle;
+
+    if(!group->events) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    pn532_group_halt(group, group->num_readers);
+    return ESP_OK;
+}
+
+esp_err_t pn532_group_get_reader(pn532_group_handle_t group_handle, size_t reader, pn532_handle_t* pn532_handle) {
+    if(!group_handle || !pn532_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_group_t* group = (pn532_group_t*) group_handle;
+
+    if(reader >= group->num_readers) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *pn532_handle = group->readers[reader];
+    return ESP_OK;
+}
+
+static void pn532_group_merge_command(pn532_stats_t* stats, const pn532_command_stats_t* src) {
+    pn532_command_stats_t* dst = NULL;
+    for(size_t i = 0; i < stats->num_commands; i++) {
+        if(stats->commands[i].command == src->command) {
+            dst = &stats->commands[i];
+            break;
+        }
+    }
+
+    if(!dst) {
+        // same rule as a single handle, the last slot is shared by the commands that don't fit
+        size_t slot = (stats->num_commands < PN532_STATS_MAX_COMMANDS - 1) ? stats->num_commands++ : PN532_STATS_MAX_COMMANDS - 1;
+        dst = &stats->commands[slot];
+        if(slot == PN532_STATS_MAX_COMMANDS - 1) {
+            dst->command = PN532_STATS_OTHER;
+            stats->num_commands = PN532_STATS_MAX_COMMANDS;
+        } else {
+            dst->command = src->command;
+        }
+    }
+
+    dst->count += src->count;
+    dst->responses += src->responses;
+    dst->timeouts += src->timeouts;
+    dst->bad_acks += src->bad_acks;
+    dst->checksum_errors += src->checksum_errors;
+    dst->retries += src->retries;
+    dst->errors += src->errors;
+    dst->bytes_out += src->bytes_out;
+    dst->bytes_in += src->bytes_in;
+    dst->write_time_us += src->write_time_us;
+    dst->ack_latency_us += src->ack_latency_us;
+    dst->response_latency_us += src->response_latency_us;
+    for(size_t i = 0; i < PN532_STATS_HIST_BUCKETS; i++) {
+        dst->ack_hist[i] += src->ack_hist[i];
+        dst->response_hist[i] += src->response_hist[i];
+    }
+}
+
+esp_err_t pn532_group_get_stats(pn532_group_handle_t group_handle, pn532_group_stats_t* stats) {
+    if(!group_handle || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_group_t* group = (pn532_group_t*) group_handle;
+
+    memset(stats, 0, sizeof(pn532_group_stats_t));
+    stats->num_readers = group->num_readers;
+
+    pn532_stats_t* reader_stats = (pn532_stats_t*) malloc(sizeof(pn532_stats_t));
+    if(!reader_stats) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for(size_t i = 0; i < group->num_readers; i++) {
+        pn532_t* pn532 = (pn532_t*) group->readers[i];
+        stats->events[i] = atomic_load(&pn532->autopoll.posted);
+        stats->dropped[i] = atomic_load(&pn532->autopoll.dropped);
+
+        if(pn532_get_stats(pn532, reader_stats) != ESP_OK) {
+            continue;
+        }
+        for(size_t j = 0; j < reader_stats->num_commands; j++) {
+            pn532_group_merge_command(&stats->commands, &reader_stats->commands[j]);
+        }
+    }
+
+    free(reader_stats);
+    return ESP_OK;
+}
@@ -0,0 +1,284 @@
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <string.h>
+
+#include "freertos/task.h"
+
+#include "esp_log.h"
+
+#define PN532_I2C_READY 0x01 // status byte, bit 0
+#define PN532_I2C_FIRST_READ 32 // frame bytes read with the status byte, fits the ack and most responses
+#define PN532_I2C_MAX_IOV 4
+#define PN532_I2C_POLL_TICKS 1 // bus is released for this long between status polls
+#define PN532_I2C_WAKE_DELAY_MS 2
+#define PN532_I2C_RESEND_TICKS (pdMS_TO_TICKS(10) + 1) // nack to the frame being ready again
+
+#define I2C_DEV(pn532) ((pn532)->i2c.dev)
+// worst case time on the bus for len bytes (9 clocks per byte) plus some slack for clock stretching
+#define XFER_TIMEOUT_MS(pn532, len) ((int) (((len) * 9 * 1000) / (pn532)->i2c.clk_speed) + 10)
+
+static const char* TAG = "pn532";
+
+extern esp_err_t pn532_irq_init(pn532_t* pn532, gpio_num_t irq);
+extern esp_err_t pn532_irq_wait(pn532_t* pn532, TickType_t timeout);
+extern void pn532_irq_free(pn532_t* pn532);
+extern esp_err_t pn532_parse_frame_header(const uint8_t* raw, size_t raw_len, size_t* start, size_t* total);
+extern esp_err_t pn532_check_frame(const uint8_t* frame, size_t total);
+
+static const uint8_t pn532_i2c_nack[] = {0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00};
+
+static esp_err_t pn532_i2c_write_frame(pn532_t* pn532, const pn532_iovec_t* iov, size_t iov_count) {
+    if(iov_count > PN532_I2C_MAX_IOV) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    #ifdef PN532_DEBUG
+        ESP_LOGD(TAG, "writing command:");
+    #endif
+
+    // the driver sends every part in one transaction, so the parts are never joined here
+    i2c_master_transmit_multi_buffer_info_t buffers[PN532_I2C_MAX_IOV];
+    size_t count = 0;
+    size_t len = 0;
+    for(size_t i = 0; i < iov_count; i++) {
+        if(!iov[i].len) {
+            continue;
+        }
+
+        #ifdef PN532_DEBUG
+            ESP_LOG_BUFFER_HEX_LEVEL(TAG, iov[i].data, iov[i].len, ESP_LOG_DEBUG);
+        #endif
+
+        buffers[count].write_buffer = (uint8_t*) iov[i].data;
+        buffers[count].buffer_size = iov[i].len;
+        len += iov[i].len;
+        count++;
+    }
+
+    esp_err_t err = i2c_master_multi_buffer_transmit(I2C_DEV(pn532), buffers, count, XFER_TIMEOUT_MS(pn532, len + 1));
+    if(err != ESP_OK) {
+        // a sleeping PN532 nacks the address that wakes it up
+        vTaskDelay(pdMS_TO_TICKS(PN532_I2C_WAKE_DELAY_MS) + 1);
+        err = i2c_master_multi_buffer_transmit(I2C_DEV(pn532), buffers, count, XFER_TIMEOUT_MS(pn532, len + 1));
+    }
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to write command: %d", err);
+        return err;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t pn532_i2c_write_raw(pn532_t* pn532, const uint8_t* data, size_t len) {
+    #ifdef PN532_DEBUG
+        ESP_LOGD(TAG, "writing raw:");
+        ESP_LOG_BUFFER_HEX_LEVEL(TAG, data, len, ESP_LOG_DEBUG);
+    #endif
+
+    esp_err_t err = i2c_master_transmit(I2C_DEV(pn532), data, len, XFER_TIMEOUT_MS(pn532, len + 1));
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to write data: %d", err);
+        return err;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t pn532_i2c_wait_ready(pn532_t* pn532, TickType_t timeout) {
+    if(pn532->irq.pin != GPIO_NUM_NC) {
+        return pn532_irq_wait(pn532, timeout);
+    }
+
+    TickType_t deadline = xTaskGetTickCount() + timeout;
+    while(true) {
+        // a single byte per poll keeps each bus hold short for other devices on the bus
+        uint8_t status = 0;
+        esp_err_t err = i2c_master_receive(I2C_DEV(pn532), &status, 1, XFER_TIMEOUT_MS(pn532, 2));
+        if(err == ESP_OK && (status & PN532_I2C_READY)) {
+            return ESP_OK;
+        }
+
+        if((int32_t) (deadline - xTaskGetTickCount()) <= 0) {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(PN532_I2C_POLL_TICKS);
+    }
+}
+
+// every read starts with the status byte, the PN532 shifts a frame out once and drops it after the read
+static esp_err_t pn532_i2c_read(pn532_t* pn532, uint8_t* data, size_t len) {
+    esp_err_t err = i2c_master_receive(I2C_DEV(pn532), data, len, XFER_TIMEOUT_MS(pn532, len + 1));
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to read response: %d", err);
+        return err;
+    }
+
+    if(!(data[0] & PN532_I2C_READY)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t pn532_i2c_read_frame(pn532_t* pn532, uint8_t* frame, size_t frame_size, size_t* frame_len, TickType_t timeout) {
+    esp_err_t err = pn532_i2c_wait_ready(pn532, timeout);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    // status + the first bytes of the frame in one transaction, short frames are complete after it
+    uint8_t head[1 + PN532_I2C_FIRST_READ];
+    err = pn532_i2c_read(pn532, head, sizeof(head));
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    size_t start = 0;
+    size_t total = 0;
+    err = pn532_parse_frame_header(&head[1], PN532_I2C_FIRST_READ, &start, &total);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    // bytes after the status byte: everything up to the start code, then the rest of the frame
+    size_t raw_len = start + total - 3;
+    if(raw_len <= PN532_I2C_FIRST_READ) {
+        if(total > frame_size) {
+            ESP_LOGE(TAG, "frame too long: %d", (int) total);
+            return ESP_ERR_INVALID_SIZE;
+        }
+        memcpy(&frame[3], &head[1 + start], total - 3);
+    } else {
+        if(1 + raw_len > frame_size) {
+            ESP_LOGE(TAG, "frame too long: %d", (int) total);
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        // the rest of the frame is gone, a nack makes the PN532 send all of it again
+        err = pn532_i2c_write_raw(pn532, pn532_i2c_nack, sizeof(pn532_i2c_nack));
+        if(err != ESP_OK) {
+            return err;
+        }
+        err = pn532_i2c_wait_ready(pn532, PN532_I2C_RESEND_TICKS);
+        if(err != ESP_OK) {
+            return err;
+        }
+        err = pn532_i2c_read(pn532, frame, 1 + raw_len);
+        if(err != ESP_OK) {
+            return err;
+        }
+
+        size_t resent_start = 0;
+        size_t resent_total = 0;
+        err = pn532_parse_frame_header(&frame[1], raw_len, &resent_start, &resent_total);
+        if(err != ESP_OK || resent_start != start || resent_total != total) {
+            ESP_LOGE(TAG, "resent frame does not match");
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        memmove(&frame[3], &frame[1 + start], total - 3);
+    }
+
+    frame[0] = PN532_PREAMBLE;
+    frame[1] = PN532_STARTCODE1;
+    frame[2] = PN532_STARTCODE2;
+
+    err = pn532_check_frame(frame, total);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    *frame_len = total;
+
+    #ifdef PN532_DEBUG
+        ESP_LOGD(TAG, "reading frame:");
+        ESP_LOG_BUFFER_HEX_LEVEL(TAG, frame, *frame_len, ESP_LOG_DEBUG);
+    #endif
+
+    return ESP_OK;
+}
+
+static esp_err_t pn532_i2c_wake_up(pn532_t* pn532) {
+    // the address phase wakes the PN532 up, it may well nack this one
+    (void) i2c_master_probe(pn532->i2c.bus, PN532_I2C_ADDRESS, XFER_TIMEOUT_MS(pn532, 1));
+    vTaskDelay(pdMS_TO_TICKS(PN532_I2C_WAKE_DELAY_MS) + 1);
+
+    return ESP_OK;
+}
+
+static esp_err_t pn532_i2c_free(pn532_t* pn532) {
+    esp_err_t err = i2c_master_bus_rm_device(I2C_DEV(pn532));
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "i2c_master_bus_rm_device failed: %d", err);
+        return err;
+    }
+
+    if(pn532->i2c.owns_bus) {
+        (void) i2c_del_master_bus(pn532->i2c.bus);
+    }
+
+    pn532_irq_free(pn532);
+
+    return ESP_OK;
+}
+
+esp_err_t pn532_i2c_init(pn532_t* pn532, const pn532_i2c_config_t* config) {
+    pn532->protocol = PN532_I2C_PROTOCOL;
+    pn532->i2c.clk_speed = config->clk_speed ? config->clk_speed : PN532_I2C_DEFAULT_CLK_SPEED;
+    pn532->i2c.bus = config->bus;
+    pn532->i2c.owns_bus = false;
+
+    esp_err_t err = ESP_OK;
+    if(!pn532->i2c.bus) {
+        const i2c_master_bus_config_t bus_config = {
+            .i2c_port = config->i2c_port,
+            .sda_io_num = config->sda,
+            .scl_io_num = config->scl,
+            .clk_source = I2C_CLK_SRC_DEFAULT,
+            .glitch_ignore_cnt = 7,
+            .flags.enable_internal_pullup = true,
+        };
+        err = i2c_new_master_bus(&bus_config, &pn532->i2c.bus);
+        if(err != ESP_OK) {
+            ESP_LOGE(TAG, "i2c_new_master_bus failed: %d", err);
+            return err;
+        }
+        pn532->i2c.owns_bus = true;
+    }
+
+    const i2c_device_config_t dev_config = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = PN532_I2C_ADDRESS,
+        .scl_speed_hz = pn532->i2c.clk_speed,
+    };
+    err = i2c_master_bus_add_device(pn532->i2c.bus, &dev_config, &I2C_DEV(pn532));
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "i2c_master_bus_add_device failed: %d", err);
+        goto ERR;
+    }
+
+    pn532->irq.pin = GPIO_NUM_NC;
+    if(config->use_irq) {
+        err = pn532_irq_init(pn532, config->irq);
+        if(err != ESP_OK) {
+            (void) i2c_master_bus_rm_device(I2C_DEV(pn532));
+            goto ERR;
+        }
+    }
+
+    pn532->write_frame = pn532_i2c_write_frame;
+    pn532->write_raw = pn532_i2c_write_raw;
+    pn532->read_frame = pn532_i2c_read_frame;
+    pn532->set_baud_rate = NULL; // HSU only
+    pn532->wake_up = pn532_i2c_wake_up;
+    pn532->free = pn532_i2c_free;
+
+    ESP_LOGI(TAG, "pn532 i2c initialized");
+    return ESP_OK;
+
+ERR:
+    if(pn532->i2c.owns_bus) {
+        (void) i2c_del_master_bus(pn532->i2c.bus);
+    }
+    return err;
+}
@@ -0,0 +1,99 @@
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include "freertos/task.h"
+
+#include "esp_log.h"
+
+#define IRQ_PIN(pn532) ((pn532)->irq.pin)
+
+static const char* TAG = "pn532";
+
+static void IRAM_ATTR pn532_irq_isr(void* arg) {
+    pn532_t* pn532 = (pn532_t*) arg;
+
+    TaskHandle_t task = pn532->irq.waiting_task;
+    if(!task) {
+        return;
+    }
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveIndexedFromISR(task, PN532_IRQ_NOTIFY_INDEX, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+esp_err_t pn532_irq_init(pn532_t* pn532, gpio_num_t irq) {
+    pn532->irq.waiting_task = NULL;
+    IRQ_PIN(pn532) = GPIO_NUM_NC;
+
+    if(!GPIO_IS_VALID_GPIO(irq)) {
+        ESP_LOGE(TAG, "invalid IRQ pin: %d", irq);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const gpio_config_t io_config = {
+        .pin_bit_mask = (1ULL << irq),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_NEGEDGE, // IRQ is active low
+    };
+    esp_err_t err = gpio_config(&io_config);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "gpio_config failed: %d", err);
+        return err;
+    }
+
+    // the ISR service may already be installed by the application or another handle
+    err = gpio_install_isr_service(0);
+    if(err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "gpio_install_isr_service failed: %d", err);
+        return err;
+    }
+
+    err = gpio_isr_handler_add(irq, pn532_irq_isr, pn532);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "gpio_isr_handler_add failed: %d", err);
+        return err;
+    }
+
+    IRQ_PIN(pn532) = irq;
+    return ESP_OK;
+}
+
+esp_err_t pn532_irq_wait(pn532_t* pn532, TickType_t timeout) {
+    if(IRQ_PIN(pn532) == GPIO_NUM_NC) {
+        return ESP_OK;
+    }
+
+    // on a shared index (PN532_IRQ_NOTIFY_INDEX 0) this may also eat the async worker's wakeup, and a request
+    // submitted meanwhile ends a wait early; both are harmless only because this loop rechecks the pin level and
+    // the worker rescans its queues after every request
+    pn532->irq.waiting_task = xTaskGetCurrentTaskHandle();
+    (void) ulTaskNotifyTakeIndexed(PN532_IRQ_NOTIFY_INDEX, pdTRUE, 0); // drop edges left over from previous frames
+
+    // check the level after arming, so an edge between both can not be missed
+    TickType_t deadline = xTaskGetTickCount() + timeout;
+    esp_err_t err = ESP_OK;
+    while(gpio_get_level(IRQ_PIN(pn532))) {
+        TickType_t now = xTaskGetTickCount();
+        TickType_t remaining = ((int32_t) (deadline - now) > 0) ? (deadline - now) : 0;
+        if(!remaining || !ulTaskNotifyTakeIndexed(PN532_IRQ_NOTIFY_INDEX, pdTRUE, remaining)) {
+            err = ESP_ERR_TIMEOUT;
+            break;
+        }
+    }
+
+    pn532->irq.waiting_task = NULL;
+    return err;
+}
+
+void pn532_irq_free(pn532_t* pn532) {
+    if(IRQ_PIN(pn532) == GPIO_NUM_NC) {
+        return;
+    }
+
+    (void) gpio_isr_handler_remove(IRQ_PIN(pn532));
+    (void) gpio_reset_pin(IRQ_PIN(pn532));
+    IRQ_PIN(pn532) = GPIO_NUM_NC;
+}
@@ -0,0 +1,257 @@
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+
+#define PN532_MIFARE_ACK_TIMEOUT 30
+#define PN532_MIFARE_TIMEOUT 100
+
+#define MIFARE_CMD_READ 0x30
+#define MIFARE_CMD_WRITE 0xA0
+
+#define MIFARE_BLOCK_SIZE 16
+#define MIFARE_MAX_SECTOR 39
+
+static const char* TAG = "pn532";
+
+extern esp_err_t pn532_run(pn532_t* pn532, pn532_priority_t priority, pn532_job_t job, void* ctx);
+extern esp_err_t pn532_transceive_data(pn532_t* pn532, const uint8_t* command, size_t command_len, const uint8_t* data, size_t data_len, uint32_t ack_timeout, uint32_t response_timeout, pn532_latency_t* latency);
+
+typedef struct {
+    const pn532_target_t* target;
+    const pn532_mifare_sector_t* sectors;
+    size_t num_sectors;
+    uint8_t* data; // read destination or write source
+    size_t data_size;
+    size_t* data_len;
+} pn532_mifare_job_t;
+
+static uint8_t pn532_mifare_first_block(uint8_t sector) {
+    return (sector < 32) ? sector * 4 : 128 + (sector - 32) * 16;
+}
+
+static uint8_t pn532_mifare_num_blocks(uint8_t sector) {
+    return (sector < 32) ? 4 : 16;
+}
+
+// InDataExchange response: D5 41 Status [DataIn]
+static esp_err_t pn532_mifare_check_status(pn532_t* pn532) {
+    const uint8_t* response = pn532->response_data;
+    if(pn532->response_data_len < 3 || response[1] != PN532_COMMAND_INDATAEXCHANGE + 1) {
+        ESP_LOGE(TAG, "failed to check data exchange response");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    if(response[2] & 0x3F) {
+        ESP_LOGE(TAG, "data exchange failed: %02X", response[2]);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    return ESP_OK;
+}
+
+// authenticates a sector unless the current session already covers it
+static esp_err_t pn532_mifare_authenticate(pn532_t* pn532, const pn532_target_t* target, const pn532_mifare_sector_t* sector) {
+    mifare_session_t* session = &pn532->mifare;
+    if(session->authenticated && session->tg == target->tg && session->sector == sector->sector &&
+       session->key_type == sector->key_type && !memcmp(session->key, sector->key, sizeof(session->key)) &&
+       !memcmp(session->uid, &target->uid[target->uid_len - 4], sizeof(session->uid))) {
+        return ESP_OK;
+    }
+    session->authenticated = false;
+
+    // the last 4 UID bytes take part in the authentication (single and double size UIDs)
+    uint8_t command[] = {
+        PN532_COMMAND_INDATAEXCHANGE,
+        target->tg,
+        sector->key_type,
+        pn532_mifare_first_block(sector->sector),
+    };
+    uint8_t params[6 + 4];
+    memcpy(params, sector->key, 6);
+    memcpy(&params[6], &target->uid[target->uid_len - 4], 4);
+
+    esp_err_t err = pn532_transceive_data(pn532, command, sizeof(command), params, sizeof(params), PN532_MIFARE_ACK_TIMEOUT, PN532_MIFARE_TIMEOUT, NULL);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    err = pn532_mifare_check_status(pn532);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to authenticate sector %d", sector->sector);
+        return err;
+    }
+
+    session->authenticated = true;
+    session->tg = target->tg;
+    session->sector = sector->sector;
+    session->key_type = sector->key_type;
+    memcpy(session->key, sector->key, sizeof(session->key));
+    memcpy(session->uid, &target->uid[target->uid_len - 4], sizeof(session->uid));
+
+    return ESP_OK;
+}
+
+static esp_err_t pn532_mifare_read_job(pn532_t* pn532, void* ctx) {
+    pn532_mifare_job_t* job = (pn532_mifare_job_t*) ctx;
+
+    size_t offset = 0;
+    for(size_t i = 0; i < job->num_sectors; i++) {
+        const pn532_mifare_sector_t* sector = &job->sectors[i];
+
+        esp_err_t err = pn532_mifare_authenticate(pn532, job->target, sector);
+        if(err != ESP_OK) {
+            return err;
+        }
+
+        uint8_t first_block = pn532_mifare_first_block(sector->sector);
+        for(uint8_t block = 0; block < pn532_mifare_num_blocks(sector->sector); block++) {
+            uint8_t command[] = {
+                PN532_COMMAND_INDATAEXCHANGE,
+                job->target->tg,
+                MIFARE_CMD_READ,
+                first_block + block,
+            };
+            err = pn532_transceive_data(pn532, command, sizeof(command), NULL, 0, PN532_MIFARE_ACK_TIMEOUT, PN532_MIFARE_TIMEOUT, NULL);
+            if(err == ESP_OK) {
+                err = pn532_mifare_check_status(pn532);
+            }
+            if(err == ESP_OK && pn532->response_data_len < 3 + MIFARE_BLOCK_SIZE) {
+                err = ESP_ERR_INVALID_RESPONSE;
+            }
+            if(err != ESP_OK) {
+                ESP_LOGE(TAG, "failed to read block %d", first_block + block);
+                pn532->mifare.authenticated = false;
+                return err;
+            }
+
+            memcpy(job->data + offset, &pn532->response_data[3], MIFARE_BLOCK_SIZE);
+            offset += MIFARE_BLOCK_SIZE;
+            *job->data_len = offset;
+        }
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t pn532_mifare_write_job(pn532_t* pn532, void* ctx) {
+    pn532_mifare_job_t* job = (pn532_mifare_job_t*) ctx;
+
+    size_t offset = 0;
+    for(size_t i = 0; i < job->num_sectors; i++) {
+        const pn532_mifare_sector_t* sector = &job->sectors[i];
+
+        esp_err_t err = pn532_mifare_authenticate(pn532, job->target, sector);
+        if(err != ESP_OK) {
+            return err;
+        }
+
+        uint8_t first_block = pn532_mifare_first_block(sector->sector);
+        for(uint8_t block = 0; block < pn532_mifare_num_blocks(sector->sector) - 1; block++) {
+            if(first_block + block == 0) {
+                continue; // manufacturer block
+            }
+
+            uint8_t command[] = {
+                PN532_COMMAND_INDATAEXCHANGE,
+                job->target->tg,
+                MIFARE_CMD_WRITE,
+                first_block + block,
+            };
+            err = pn532_transceive_data(pn532, command, sizeof(command), job->data + offset, MIFARE_BLOCK_SIZE, PN532_MIFARE_ACK_TIMEOUT, PN532_MIFARE_TIMEOUT, NULL);
+            if(err == ESP_OK) {
+                err = pn532_mifare_check_status(pn532);
+            }
+            if(err != ESP_OK) {
+                ESP_LOGE(TAG, "failed to write block %d", first_block + block);
+                pn532->mifare.authenticated = false;
+                return err;
+            }
+
+            offset += MIFARE_BLOCK_SIZE;
+            *job->data_len = offset;
+        }
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t pn532_mifare_check_args(const pn532_target_t* target, const pn532_mifare_sector_t* sectors, size_t num_sectors) {
+    if(!target || !sectors || !num_sectors || target->uid_len < 4) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for(size_t i = 0; i < num_sectors; i++) {
+        if(sectors[i].sector > MIFARE_MAX_SECTOR || (sectors[i].key_type != PN532_MIFARE_KEY_A && sectors[i].key_type != PN532_MIFARE_KEY_B)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t pn532_mifare_classic_read_sectors(pn532_handle_t pn532_handle, const pn532_target_t* target, const pn532_mifare_sector_t* sectors, size_t num_sectors, uint8_t* data, size_t data_size, size_t* data_len) {
+    if(!pn532_handle || !data || !data_len || pn532_mifare_check_args(target, sectors, num_sectors) != ESP_OK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t required = 0;
+    for(size_t i = 0; i < num_sectors; i++) {
+        required += pn532_mifare_num_blocks(sectors[i].sector) * MIFARE_BLOCK_SIZE;
+    }
+    if(data_size < required) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    *data_len = 0;
+    pn532_mifare_job_t job = {
+        .target = target,
+        .sectors = sectors,
+        .num_sectors = num_sectors,
+        .data = data,
+        .data_size = data_size,
+        .data_len = data_len,
+    };
+    esp_err_t err = pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_mifare_read_job, &job);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to read sectors");
+    }
+
+    return err;
+}
+
+esp_err_t pn532_mifare_classic_write_sectors(pn532_handle_t pn532_handle, const pn532_target_t* target, const pn532_mifare_sector_t* sectors, size_t num_sectors, const uint8_t* data, size_t data_len) {
+    if(!pn532_handle || !data || pn532_mifare_check_args(target, sectors, num_sectors) != ESP_OK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t required = 0;
+    for(size_t i = 0; i < num_sectors; i++) {
+        required += (pn532_mifare_num_blocks(sectors[i].sector) - ((sectors[i].sector == 0) ? 2 : 1)) * MIFARE_BLOCK_SIZE;
+    }
+    if(data_len != required) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    size_t written = 0;
+    pn532_mifare_job_t job = {
+        .target = target,
+        .sectors = sectors,
+        .num_sectors = num_sectors,
+        .data = (uint8_t*) data,
+        .data_size = data_len,
+        .data_len = &written,
+    };
+    esp_err_t err = pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_mifare_write_job, &job);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to write sectors (%d bytes written)", (int) written);
+    }
+
+    return err;
+}
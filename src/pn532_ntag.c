@@ -0,0 +1,210 @@
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+
+#define PN532_NTAG_ACK_TIMEOUT 30
+#define PN532_NTAG_TIMEOUT 100
+
+#define NTAG_CMD_GET_VERSION 0x60
+#define NTAG_CMD_FAST_READ 0x3A
+
+#define NTAG_PAGE_SIZE 4
+#define NTAG_USER_START_PAGE 4
+#define NTAG_MAX_FAST_READ_PAGES 64 // keeps DataIn inside the PN532 262 byte limit
+
+static const char* TAG = "pn532";
+
+extern esp_err_t pn532_run(pn532_t* pn532, pn532_priority_t priority, pn532_job_t job, void* ctx);
+extern esp_err_t pn532_transceive_data(pn532_t* pn532, const uint8_t* command, size_t command_len, const uint8_t* data, size_t data_len, uint32_t ack_timeout, uint32_t response_timeout, pn532_latency_t* latency);
+
+typedef struct {
+    uint8_t start_page;
+    uint8_t* data;
+    size_t len;
+    size_t* data_len;
+    uint8_t* version;
+} pn532_ntag_job_t;
+
+// sends a raw tag command with InCommunicateThru, response: D5 43 Status DataIn
+static esp_err_t pn532_ntag_communicate(pn532_t* pn532, const uint8_t* tag_command, size_t tag_command_len, size_t expected_len) {
+    esp_err_t err = pn532_transceive_data(pn532, (uint8_t[]) {PN532_COMMAND_INCOMMUNICATETHRU}, 1, tag_command, tag_command_len, PN532_NTAG_ACK_TIMEOUT, PN532_NTAG_TIMEOUT, NULL);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    const uint8_t* response = pn532->response_data;
+    if(pn532->response_data_len < 3 || response[1] != PN532_COMMAND_INCOMMUNICATETHRU + 1) {
+        ESP_LOGE(TAG, "failed to check communicate thru response");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    if(response[2] & 0x3F) {
+        ESP_LOGE(TAG, "communicate thru failed: %02X", response[2]);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    if(pn532->response_data_len - 3 < expected_len) {
+        ESP_LOGE(TAG, "short tag response: %d", (int) (pn532->response_data_len - 3));
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    return ESP_OK;
+}
+
+// largest FAST_READ that fits both the PN532 and the handle buffer
+static size_t pn532_ntag_max_pages(pn532_t* pn532) {
+    // ack + extended header + TFI, response code, status + DCS, postamble
+    size_t available = pn532->buffer_size - ACK_OFFSET - 8 - 3 - 2;
+    size_t pages = available / NTAG_PAGE_SIZE;
+    return (pages > NTAG_MAX_FAST_READ_PAGES) ? NTAG_MAX_FAST_READ_PAGES : pages;
+}
+
+static esp_err_t pn532_ntag_fast_read(pn532_t* pn532, uint8_t start_page, uint8_t* data, size_t len) {
+    size_t max_pages = pn532_ntag_max_pages(pn532);
+    size_t pages = (len + NTAG_PAGE_SIZE - 1) / NTAG_PAGE_SIZE;
+
+    size_t offset = 0;
+    while(pages) {
+        size_t chunk = (pages > max_pages) ? max_pages : pages;
+        uint8_t tag_command[] = {
+            NTAG_CMD_FAST_READ,
+            start_page,
+            start_page + chunk - 1,
+        };
+        esp_err_t err = pn532_ntag_communicate(pn532, tag_command, sizeof(tag_command), chunk * NTAG_PAGE_SIZE);
+        if(err != ESP_OK) {
+            ESP_LOGE(TAG, "failed to read pages %d ~ %d", tag_command[1], tag_command[2]);
+            return err;
+        }
+
+        size_t copy = chunk * NTAG_PAGE_SIZE;
+        if(copy > len - offset) {
+            copy = len - offset;
+        }
+        memcpy(data + offset, &pn532->response_data[3], copy);
+
+        offset += copy;
+        start_page += chunk;
+        pages -= chunk;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t pn532_ntag_get_version_raw(pn532_t* pn532, uint8_t* version) {
+    esp_err_t err = pn532_ntag_communicate(pn532, (uint8_t[]) {NTAG_CMD_GET_VERSION}, 1, PN532_NTAG_VERSION_LEN);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to get tag version");
+        return err;
+    }
+
+    memcpy(version, &pn532->response_data[3], PN532_NTAG_VERSION_LEN);
+    return ESP_OK;
+}
+
+// user memory size from the GET_VERSION storage size byte
+static size_t pn532_ntag_user_memory_size(const uint8_t* version) {
+    switch(version[6]) {
+        case 0x0B: return 48; // NTAG210, Ultralight EV1 (MF0UL11)
+        case 0x0E: return 128; // NTAG212, Ultralight EV1 (MF0UL21)
+        case 0x0F: return 144; // NTAG213
+        case 0x11: return 504; // NTAG215
+        case 0x13: return 888; // NTAG216
+        default: return 0;
+    }
+}
+
+static esp_err_t pn532_ntag_get_version_job(pn532_t* pn532, void* ctx) {
+    pn532_ntag_job_t* job = (pn532_ntag_job_t*) ctx;
+    return pn532_ntag_get_version_raw(pn532, job->version);
+}
+
+static esp_err_t pn532_ntag_read_job(pn532_t* pn532, void* ctx) {
+    pn532_ntag_job_t* job = (pn532_ntag_job_t*) ctx;
+    return pn532_ntag_fast_read(pn532, job->start_page, job->data, job->len);
+}
+
+static esp_err_t pn532_ntag_read_user_memory_job(pn532_t* pn532, void* ctx) {
+    pn532_ntag_job_t* job = (pn532_ntag_job_t*) ctx;
+
+    uint8_t version[PN532_NTAG_VERSION_LEN];
+    esp_err_t err = pn532_ntag_get_version_raw(pn532, version);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    size_t size = pn532_ntag_user_memory_size(version);
+    if(!size) {
+        ESP_LOGE(TAG, "unknown tag storage size: %02X", version[6]);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if(size > job->len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    err = pn532_ntag_fast_read(pn532, NTAG_USER_START_PAGE, job->data, size);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    *job->data_len = size;
+    return ESP_OK;
+}
+
+esp_err_t pn532_ntag_get_version(pn532_handle_t pn532_handle, uint8_t* version) {
+    if(!pn532_handle || !version) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    pn532_ntag_job_t job = {
+        .version = version,
+    };
+    return pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_ntag_get_version_job, &job);
+}
+
+esp_err_t pn532_ntag_read(pn532_handle_t pn532_handle, uint8_t start_page, uint8_t* data, size_t len) {
+    if(!pn532_handle || !data || !len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    pn532_ntag_job_t job = {
+        .start_page = start_page,
+        .data = data,
+        .len = len,
+    };
+    esp_err_t err = pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_ntag_read_job, &job);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to read tag");
+    }
+
+    return err;
+}
+
+esp_err_t pn532_ntag_read_user_memory(pn532_handle_t pn532_handle, uint8_t* data, size_t data_size, size_t* data_len) {
+    if(!pn532_handle || !data || !data_len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    *data_len = 0;
+    pn532_ntag_job_t job = {
+        .data = data,
+        .len = data_size,
+        .data_len = data_len,
+    };
+    esp_err_t err = pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_ntag_read_user_memory_job, &job);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to read tag user memory");
+    }
+
+    return err;
+}
@@ -0,0 +1,217 @@
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <string.h>
+
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define PN532_POWER_ACK_TIMEOUT 30
+#define PN532_POWER_TIMEOUT 100
+#define PN532_POWER_ACTIVATION_MS 10 // upper bound of one passive activation attempt on an empty field
+
+static const char* TAG = "pn532";
+
+extern esp_err_t pn532_run(pn532_t* pn532, pn532_priority_t priority, pn532_job_t job, void* ctx);
+extern esp_err_t pn532_transceive(pn532_t* pn532, const uint8_t* command, size_t command_len, uint32_t ack_timeout, uint32_t response_timeout, pn532_latency_t* latency);
+extern esp_err_t pn532_irq_wait(pn532_t* pn532, TickType_t timeout);
+extern void pn532_register_cache_clear(pn532_t* pn532);
+extern esp_err_t pn532_parse_target_106a(const uint8_t* data, size_t len, bool has_tg, pn532_target_t* target, size_t* consumed);
+
+// called before the first command after a power down, the caller must hold the handle mutex
+esp_err_t pn532_wake(pn532_t* pn532) {
+    int64_t started_at = esp_timer_get_time();
+
+    esp_err_t err = pn532->wake_up(pn532);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to wake up");
+        return err;
+    }
+
+    // the CIU comes back from power down with its reset values
+    pn532_register_cache_clear(pn532);
+
+    int64_t now = esp_timer_get_time();
+    pn532->power.powered_down = false;
+    pn532->power.stats.sleep_us += started_at - pn532->power.down_at;
+    pn532->power.stats.wake_us += now - started_at;
+
+    return ESP_OK;
+}
+
+static uint8_t pn532_transport_wake_source(pn532_t* pn532) {
+    switch(pn532->protocol) {
+        case PN532_I2C_PROTOCOL:
+            return PN532_WAKEUP_I2C;
+        case PN532_SPI_PROTOCOL:
+            return PN532_WAKEUP_SPI;
+        default:
+            return PN532_WAKEUP_HSU;
+    }
+}
+
+static esp_err_t pn532_power_down_job(pn532_t* pn532, void* ctx) {
+    uint8_t wake_sources = *(const uint8_t*) ctx;
+
+    uint8_t command[] = {
+        PN532_COMMAND_POWERDOWN,
+        wake_sources | pn532_transport_wake_source(pn532),
+        (pn532->irq.pin != GPIO_NUM_NC) ? 0x01 : 0x00, // assert IRQ on wake-up
+    };
+    esp_err_t err = pn532_transceive(pn532, command, sizeof(command), PN532_POWER_ACK_TIMEOUT, PN532_POWER_TIMEOUT, NULL);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    // D5 17 Status
+    const uint8_t* response = pn532->response_data;
+    if(pn532->response_data_len < 3 || response[1] != PN532_COMMAND_POWERDOWN + 1 || (response[2] & 0x3F)) {
+        ESP_LOGE(TAG, "failed to check power down response");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    pn532->power.powered_down = true;
+    pn532->power.down_at = esp_timer_get_time();
+    pn532->power.stats.cycles++;
+
+    return ESP_OK;
+}
+
+esp_err_t pn532_power_down(pn532_handle_t pn532_handle, uint8_t wake_sources) {
+    if(!pn532_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    esp_err_t err = pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_power_down_job, &wake_sources);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to power down");
+        return err;
+    }
+
+    return ESP_OK;
+}
+
+typedef struct {
+    pn532_target_t* target;
+    uint32_t timeout; // covers every activation attempt of the scan
+    bool found;
+} pn532_lowpower_scan_job_t;
+
+// wakes the PN532 up (inside the first command) and looks for one target
+static esp_err_t pn532_lowpower_scan_job(pn532_t* pn532, void* ctx) {
+    pn532_lowpower_scan_job_t* job = (pn532_lowpower_scan_job_t*) ctx;
+
+    int64_t woke_at = esp_timer_get_time();
+    uint64_t wake_us = pn532->power.stats.wake_us;
+
+    uint8_t command[] = {
+        PN532_COMMAND_INLISTPASSIVETARGET,
+        0x01, // max targets
+        PN532_MIFARE_ISO14443A,
+    };
+    esp_err_t err = pn532_transceive(pn532, command, sizeof(command), PN532_POWER_ACK_TIMEOUT, job->timeout, NULL);
+
+    // time spent in the wake-up sequence is accounted by pn532_wake()
+    int64_t now = esp_timer_get_time();
+    pn532->power.stats.scan_us += (now - woke_at) - (pn532->power.stats.wake_us - wake_us);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    // D5 4B NbTg TargetData
+    const uint8_t* response = pn532->response_data;
+    if(pn532->response_data_len < 3 || response[1] != PN532_COMMAND_INLISTPASSIVETARGET + 1) {
+        ESP_LOGE(TAG, "failed to check passive target response");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    if(!response[2]) {
+        return ESP_OK;
+    }
+
+    size_t consumed = 0;
+    err = pn532_parse_target_106a(&response[3], pn532->response_data_len - 3, true, job->target, &consumed);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "malformed target data");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    job->found = true;
+    pn532->power.stats.last_wake_to_uid_us = (uint32_t) (esp_timer_get_time() - woke_at);
+    return ESP_OK;
+}
+
+esp_err_t pn532_lowpower_scan(pn532_handle_t pn532_handle, const pn532_lowpower_config_t* config, uint32_t timeout, pn532_target_t* target) {
+    if(!pn532_handle || !config || !target || config->scan_retries == 0xFF) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    // kept by the PN532 through power down, so each cycle is only PowerDown + InListPassiveTarget
+    esp_err_t err = pn532_set_passive_activation_retries(pn532_handle, config->scan_retries);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    int64_t deadline = esp_timer_get_time() + 1000LL * timeout;
+    while(true) {
+        err = pn532_power_down(pn532_handle, config->wake_sources);
+        if(err != ESP_OK) {
+            return err;
+        }
+
+        // an extra wake source asserts IRQ, otherwise the host timer ends the sleep
+        if(pn532->irq.pin != GPIO_NUM_NC && config->wake_sources) {
+            (void) pn532_irq_wait(pn532, pdMS_TO_TICKS(config->sleep_ms));
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(config->sleep_ms));
+        }
+
+        pn532_lowpower_scan_job_t job = {
+            .target = target,
+            .timeout = PN532_POWER_TIMEOUT + (config->scan_retries + 1) * PN532_POWER_ACTIVATION_MS,
+            .found = false,
+        };
+        err = pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_lowpower_scan_job, &job);
+        if(err != ESP_OK) {
+            ESP_LOGE(TAG, "failed to scan");
+            return err;
+        }
+
+        if(job.found) {
+            return ESP_OK;
+        }
+
+        if(esp_timer_get_time() > deadline) {
+            return ESP_ERR_NOT_FOUND;
+        }
+    }
+}
+
+static esp_err_t pn532_get_lowpower_stats_job(pn532_t* pn532, void* ctx) {
+    pn532_lowpower_stats_t* stats = (pn532_lowpower_stats_t*) ctx;
+
+    *stats = pn532->power.stats;
+
+    // a sleep still in progress counts up to now
+    if(pn532->power.powered_down) {
+        stats->sleep_us += esp_timer_get_time() - pn532->power.down_at;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t pn532_get_lowpower_stats(pn532_handle_t pn532_handle, pn532_lowpower_stats_t* stats) {
+    if(!pn532_handle || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    return pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_get_lowpower_stats_job, stats);
+}
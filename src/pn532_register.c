@@ -0,0 +1,209 @@
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+
+#define PN532_REGISTER_ACK_TIMEOUT 30
+#define PN532_REGISTER_TIMEOUT 100
+#define PN532_REGISTER_MAX_DATA 253 // normal frame LEN minus TFI and command code
+#define PN532_REGISTER_MAX_READ (PN532_REGISTER_MAX_DATA / 2) // ADRh ADRl per register
+#define PN532_REGISTER_MAX_WRITE (PN532_REGISTER_MAX_DATA / 3) // ADRh ADRl Val per register
+
+static const char* TAG = "pn532";
+
+extern esp_err_t pn532_run(pn532_t* pn532, pn532_priority_t priority, pn532_job_t job, void* ctx);
+extern esp_err_t pn532_transceive_data(pn532_t* pn532, const uint8_t* command, size_t command_len, const uint8_t* data, size_t data_len, uint32_t ack_timeout, uint32_t response_timeout, pn532_latency_t* latency);
+
+static bool pn532_register_cached(uint16_t address) {
+    return address >= PN532_CIU_BASE && address < PN532_CIU_BASE + PN532_CIU_SIZE;
+}
+
+// dropped whenever the CIU may have been reset behind the cache, the caller must hold the handle mutex
+void pn532_register_cache_clear(pn532_t* pn532) {
+    pn532->registers.valid = 0;
+}
+
+typedef struct {
+    const uint16_t* addresses;
+    uint8_t* values;
+    size_t count;
+} pn532_read_registers_job_t;
+
+static esp_err_t pn532_read_registers_job(pn532_t* pn532, void* ctx) {
+    pn532_read_registers_job_t* job = (pn532_read_registers_job_t*) ctx;
+
+    // the response (D5 07 Val...) must fit the handle buffer too
+    size_t max_chunk = pn532->buffer_size - ACK_OFFSET - 11;
+    if(max_chunk > PN532_REGISTER_MAX_READ) {
+        max_chunk = PN532_REGISTER_MAX_READ;
+    }
+
+    uint8_t data[PN532_REGISTER_MAX_DATA];
+    for(size_t done = 0; done < job->count;) {
+        size_t chunk = job->count - done;
+        if(chunk > max_chunk) {
+            chunk = max_chunk;
+        }
+
+        for(size_t i = 0; i < chunk; i++) {
+            data[2 * i] = job->addresses[done + i] >> 8;
+            data[2 * i + 1] = job->addresses[done + i] & 0xFF;
+        }
+
+        uint8_t command[] = {PN532_COMMAND_READREGISTER};
+        esp_err_t err = pn532_transceive_data(pn532, command, sizeof(command), data, 2 * chunk, PN532_REGISTER_ACK_TIMEOUT, PN532_REGISTER_TIMEOUT, NULL);
+        if(err != ESP_OK) {
+            return err;
+        }
+
+        // D5 07 Val1 ... ValN
+        const uint8_t* response = pn532->response_data;
+        if(pn532->response_data_len != 2 + chunk || response[1] != PN532_COMMAND_READREGISTER + 1) {
+            ESP_LOGE(TAG, "failed to check read register response");
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+
+        memcpy(&job->values[done], &response[2], chunk);
+        done += chunk;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t pn532_read_registers(pn532_handle_t pn532_handle, const uint16_t* addresses, uint8_t* values, size_t count) {
+    if(!pn532_handle || !addresses || !values || !count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    pn532_read_registers_job_t job = {
+        .addresses = addresses,
+        .values = values,
+        .count = count,
+    };
+    esp_err_t err = pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_read_registers_job, &job);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to read registers");
+        return err;
+    }
+
+    return ESP_OK;
+}
+
+typedef struct {
+    const pn532_register_t* registers;
+    size_t count;
+    size_t written;
+} pn532_write_registers_job_t;
+
+// sends one WriteRegister frame, the cache only learns the values once the PN532 confirmed them
+static esp_err_t pn532_write_registers_flush(pn532_t* pn532, const uint8_t* data, size_t len) {
+    uint8_t command[] = {PN532_COMMAND_WRITEREGISTER};
+    esp_err_t err = pn532_transceive_data(pn532, command, sizeof(command), data, len, PN532_REGISTER_ACK_TIMEOUT, PN532_REGISTER_TIMEOUT, NULL);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    // D5 09
+    if(pn532->response_data_len < 2 || pn532->response_data[1] != PN532_COMMAND_WRITEREGISTER + 1) {
+        ESP_LOGE(TAG, "failed to check write register response");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    for(size_t i = 0; i < len; i += 3) {
+        uint16_t address = (data[i] << 8) | data[i + 1];
+        if(pn532_register_cached(address)) {
+            size_t index = address - PN532_CIU_BASE;
+            pn532->registers.values[index] = data[i + 2];
+            pn532->registers.valid |= 1ULL << index;
+        }
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t pn532_write_registers_job(pn532_t* pn532, void* ctx) {
+    pn532_write_registers_job_t* job = (pn532_write_registers_job_t*) ctx;
+
+    uint8_t data[3 * PN532_REGISTER_MAX_WRITE];
+    size_t len = 0;
+    for(size_t i = 0; i < job->count; i++) {
+        const pn532_register_t* reg = &job->registers[i];
+
+        if(pn532_register_cached(reg->address)) {
+            size_t index = reg->address - PN532_CIU_BASE;
+            if((pn532->registers.valid & (1ULL << index)) && pn532->registers.values[index] == reg->value) {
+                continue;
+            }
+        }
+
+        data[len++] = reg->address >> 8;
+        data[len++] = reg->address & 0xFF;
+        data[len++] = reg->value;
+
+        if(len == sizeof(data)) {
+            esp_err_t err = pn532_write_registers_flush(pn532, data, len);
+            if(err != ESP_OK) {
+                return err;
+            }
+            job->written += len / 3;
+            len = 0;
+        }
+    }
+
+    if(!len) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = pn532_write_registers_flush(pn532, data, len);
+    if(err != ESP_OK) {
+        return err;
+    }
+    job->written += len / 3;
+
+    return ESP_OK;
+}
+
+esp_err_t pn532_write_registers(pn532_handle_t pn532_handle, const pn532_register_t* registers, size_t count, size_t* written) {
+    if(!pn532_handle || !registers || !count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    pn532_write_registers_job_t job = {
+        .registers = registers,
+        .count = count,
+        .written = 0,
+    };
+    esp_err_t err = pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_write_registers_job, &job);
+    if(written) {
+        *written = job.written;
+    }
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to write registers");
+        return err;
+    }
+
+    #ifdef PN532_DEBUG
+        ESP_LOGD(TAG, "wrote %d of %d registers", (int) job.written, (int) count);
+    #endif
+
+    return ESP_OK;
+}
+
+static esp_err_t pn532_invalidate_register_cache_job(pn532_t* pn532, void* ctx) {
+    pn532_register_cache_clear(pn532);
+    return ESP_OK;
+}
+
+esp_err_t pn532_invalidate_register_cache(pn532_handle_t pn532_handle) {
+    if(!pn532_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return pn532_run((pn532_t*) pn532_handle, PN532_PRIORITY_NORMAL, pn532_invalidate_register_cache_job, NULL);
+}
@@ -0,0 +1,317 @@
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <string.h>
+
+#include "freertos/task.h"
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+#define PN532_SPI_DATAWRITE 0x01
+#define PN532_SPI_STATREAD 0x02
+#define PN532_SPI_DATAREAD 0x03
+
+#define PN532_SPI_READY 0x01 // status byte, bit 0
+#define PN532_SPI_HEADER_LEN 8 // preamble + start code + longest header (extended), keeps the rest 4 byte aligned
+#define PN532_SPI_TX_SIZE (8 + PN532_MAX_FRAME_DATA + 2) // largest extended frame
+#define PN532_SPI_POLL_TICKS 1 // bus is released for this long between status polls
+#define PN532_SPI_WAKE_DELAY_MS 2
+
+#define SPI_DEV(pn532) ((pn532)->spi.dev)
+#define ALIGN4(len) (((len) + 3) & ~3)
+
+static const char* TAG = "pn532";
+
+extern esp_err_t pn532_irq_init(pn532_t* pn532, gpio_num_t irq);
+extern esp_err_t pn532_irq_wait(pn532_t* pn532, TickType_t timeout);
+extern void pn532_irq_free(pn532_t* pn532);
+extern esp_err_t pn532_parse_frame_header(const uint8_t* raw, size_t raw_len, size_t* start, size_t* total);
+extern esp_err_t pn532_check_frame(const uint8_t* frame, size_t total);
+
+// the PN532 is LSB first, the peripheral shifts it out that way (SPI_DEVICE_BIT_LSBFIRST) so no byte is ever reversed here
+static esp_err_t pn532_spi_write(pn532_t* pn532, size_t len) {
+    spi_transaction_t transaction = {
+        .cmd = PN532_SPI_DATAWRITE,
+        .length = len * 8,
+        .tx_buffer = pn532->spi.tx,
+    };
+    esp_err_t err = spi_device_polling_transmit(SPI_DEV(pn532), &transaction);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to write command: %d", err);
+        return err;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t pn532_spi_write_frame(pn532_t* pn532, const pn532_iovec_t* iov, size_t iov_count) {
+    #ifdef PN532_DEBUG
+        ESP_LOGD(TAG, "writing command:");
+    #endif
+
+    // DMA needs one contiguous buffer, frames are short so gathering them is cheaper than a transaction per part
+    size_t len = 0;
+    for(size_t i = 0; i < iov_count; i++) {
+        if(len + iov[i].len > PN532_SPI_TX_SIZE) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        memcpy(pn532->spi.tx + len, iov[i].data, iov[i].len);
+        len += iov[i].len;
+    }
+
+    #ifdef PN532_DEBUG
+        ESP_LOG_BUFFER_HEX_LEVEL(TAG, pn532->spi.tx, len, ESP_LOG_DEBUG);
+    #endif
+
+    return pn532_spi_write(pn532, len);
+}
+
+static esp_err_t pn532_spi_write_raw(pn532_t* pn532, const uint8_t* data, size_t len) {
+    #ifdef PN532_DEBUG
+        ESP_LOGD(TAG, "writing raw:");
+        ESP_LOG_BUFFER_HEX_LEVEL(TAG, data, len, ESP_LOG_DEBUG);
+    #endif
+
+    if(len > PN532_SPI_TX_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(pn532->spi.tx, data, len);
+
+    return pn532_spi_write(pn532, len);
+}
+
+static esp_err_t pn532_spi_wait_ready(pn532_t* pn532, TickType_t timeout) {
+    if(pn532->irq.pin != GPIO_NUM_NC) {
+        return pn532_irq_wait(pn532, timeout);
+    }
+
+    TickType_t deadline = xTaskGetTickCount() + timeout;
+    while(true) {
+        // status comes back in the transaction itself, no DMA setup for a single byte
+        spi_transaction_t transaction = {
+            .flags = SPI_TRANS_USE_RXDATA,
+            .cmd = PN532_SPI_STATREAD,
+            .length = 8,
+            .rxlength = 8,
+        };
+        esp_err_t err = spi_device_polling_transmit(SPI_DEV(pn532), &transaction);
+        if(err == ESP_OK && (transaction.rx_data[0] & PN532_SPI_READY)) {
+            return ESP_OK;
+        }
+
+        if((int32_t) (deadline - xTaskGetTickCount()) <= 0) {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(PN532_SPI_POLL_TICKS);
+    }
+}
+
+static esp_err_t pn532_spi_wake_up(pn532_t* pn532) {
+    // chip select going low wakes the PN532 up, a status read is the shortest transaction that does it
+    spi_transaction_t transaction = {
+        .flags = SPI_TRANS_USE_RXDATA,
+        .cmd = PN532_SPI_STATREAD,
+        .length = 8,
+        .rxlength = 8,
+    };
+    esp_err_t err = spi_device_polling_transmit(SPI_DEV(pn532), &transaction);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to wake up: %d", err);
+        return err;
+    }
+    vTaskDelay(pdMS_TO_TICKS(PN532_SPI_WAKE_DELAY_MS) + 1);
+
+    return ESP_OK;
+}
+
+static esp_err_t pn532_spi_read_frame(pn532_t* pn532, uint8_t* frame, size_t frame_size, size_t* frame_len, TickType_t timeout) {
+    esp_err_t err = pn532_spi_wait_ready(pn532, timeout);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    // header and rest of the frame are two transactions under one chip select, the bus is held between them
+    err = spi_device_acquire_bus(SPI_DEV(pn532), portMAX_DELAY);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "spi_device_acquire_bus failed: %d", err);
+        return err;
+    }
+
+    uint8_t* raw = pn532->spi.rx;
+    spi_transaction_t header = {
+        .flags = SPI_TRANS_CS_KEEP_ACTIVE,
+        .cmd = PN532_SPI_DATAREAD,
+        .length = PN532_SPI_HEADER_LEN * 8,
+        .rxlength = PN532_SPI_HEADER_LEN * 8,
+        .rx_buffer = raw,
+    };
+    err = spi_device_polling_transmit(SPI_DEV(pn532), &header);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to read response: %d", err);
+        goto END;
+    }
+
+    size_t start = 0;
+    size_t total = 0;
+    esp_err_t parse_err = pn532_parse_frame_header(raw, PN532_SPI_HEADER_LEN, &start, &total);
+
+    // the rest of the frame, or a single byte only to release chip select
+    size_t raw_len = start + total - 3;
+    size_t rest = 1;
+    if(parse_err == ESP_OK && raw_len > PN532_SPI_HEADER_LEN) {
+        rest = raw_len - PN532_SPI_HEADER_LEN;
+    }
+    // nothing is written to frame unless the whole frame fits in frame_size
+    if(PN532_SPI_HEADER_LEN + rest > pn532->spi.rx_size || (parse_err == ESP_OK && total > frame_size)) {
+        ESP_LOGE(TAG, "frame too long: %d", (int) total);
+        parse_err = ESP_ERR_INVALID_SIZE;
+        rest = 1;
+    }
+
+    spi_transaction_ext_t body = {
+        .base = {
+            .flags = SPI_TRANS_VARIABLE_CMD,
+            .length = rest * 8,
+            .rxlength = rest * 8,
+            .rx_buffer = raw + PN532_SPI_HEADER_LEN,
+        },
+        .command_bits = 0,
+    };
+    err = spi_device_polling_transmit(SPI_DEV(pn532), &body.base);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to read response: %d", err);
+        goto END;
+    }
+
+    err = parse_err;
+    if(err != ESP_OK) {
+        goto END;
+    }
+
+    frame[0] = PN532_PREAMBLE;
+    frame[1] = PN532_STARTCODE1;
+    frame[2] = PN532_STARTCODE2;
+    memcpy(&frame[3], &raw[start], total - 3);
+
+    err = pn532_check_frame(frame, total);
+    if(err != ESP_OK) {
+        goto END;
+    }
+
+    *frame_len = total;
+
+    #ifdef PN532_DEBUG
+        ESP_LOGD(TAG, "reading frame:");
+        ESP_LOG_BUFFER_HEX_LEVEL(TAG, frame, *frame_len, ESP_LOG_DEBUG);
+    #endif
+
+END:
+    spi_device_release_bus(SPI_DEV(pn532));
+    return err;
+}
+
+static void pn532_spi_release(pn532_t* pn532) {
+    heap_caps_free(pn532->spi.tx);
+    heap_caps_free(pn532->spi.rx);
+    pn532->spi.tx = NULL;
+    pn532->spi.rx = NULL;
+
+    if(pn532->spi.owns_bus) {
+        (void) spi_bus_free(pn532->spi.host);
+    }
+}
+
+static esp_err_t pn532_spi_free(pn532_t* pn532) {
+    esp_err_t err = spi_bus_remove_device(SPI_DEV(pn532));
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "spi_bus_remove_device failed: %d", err);
+        return err;
+    }
+
+    pn532_irq_free(pn532);
+    pn532_spi_release(pn532);
+
+    return ESP_OK;
+}
+
+esp_err_t pn532_spi_init(pn532_t* pn532, const pn532_spi_config_t* config) {
+    uint32_t clk_speed = config->clk_speed ? config->clk_speed : PN532_SPI_DEFAULT_CLK_SPEED;
+    if(clk_speed > PN532_SPI_MAX_CLK_SPEED) {
+        ESP_LOGE(TAG, "invalid SPI clock: %lu", (unsigned long) clk_speed);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532->protocol = PN532_SPI_PROTOCOL;
+    pn532->spi.host = config->spi_host;
+    pn532->spi.owns_bus = false;
+
+    // header + longest frame the handle buffer takes + the byte that releases chip select
+    pn532->spi.rx_size = ALIGN4(PN532_SPI_HEADER_LEN + pn532->buffer_size + 1);
+    pn532->spi.tx = heap_caps_malloc(ALIGN4(PN532_SPI_TX_SIZE), MALLOC_CAP_DMA);
+    pn532->spi.rx = heap_caps_malloc(pn532->spi.rx_size, MALLOC_CAP_DMA);
+    if(!pn532->spi.tx || !pn532->spi.rx) {
+        ESP_LOGE(TAG, "failed to allocate DMA buffers");
+        pn532_spi_release(pn532);
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = ESP_OK;
+    if(!config->bus_initialized) {
+        // the largest transaction is either a full extended frame write or a full read
+        size_t max_transfer = ALIGN4(PN532_SPI_TX_SIZE);
+        if(pn532->spi.rx_size > max_transfer) {
+            max_transfer = pn532->spi.rx_size;
+        }
+        const spi_bus_config_t bus_config = {
+            .mosi_io_num = config->mosi,
+            .miso_io_num = config->miso,
+            .sclk_io_num = config->sclk,
+            .quadwp_io_num = -1,
+            .quadhd_io_num = -1,
+            .max_transfer_sz = max_transfer,
+        };
+        err = spi_bus_initialize(config->spi_host, &bus_config, SPI_DMA_CH_AUTO);
+        if(err != ESP_OK) {
+            ESP_LOGE(TAG, "spi_bus_initialize failed: %d", err);
+            pn532_spi_release(pn532);
+            return err;
+        }
+        pn532->spi.owns_bus = true;
+    }
+
+    const spi_device_interface_config_t dev_config = {
+        .command_bits = 8, // DW / SR / DR prefix
+        .mode = 0,
+        .clock_speed_hz = clk_speed,
+        .spics_io_num = config->cs,
+        .flags = SPI_DEVICE_BIT_LSBFIRST,
+        .queue_size = 1,
+    };
+    err = spi_bus_add_device(config->spi_host, &dev_config, &SPI_DEV(pn532));
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "spi_bus_add_device failed: %d", err);
+        pn532_spi_release(pn532);
+        return err;
+    }
+
+    pn532->irq.pin = GPIO_NUM_NC;
+    if(config->use_irq) {
+        err = pn532_irq_init(pn532, config->irq);
+        if(err != ESP_OK) {
+            (void) spi_bus_remove_device(SPI_DEV(pn532));
+            pn532_spi_release(pn532);
+            return err;
+        }
+    }
+
+    pn532->write_frame = pn532_spi_write_frame;
+    pn532->write_raw = pn532_spi_write_raw;
+    pn532->read_frame = pn532_spi_read_frame;
+    pn532->set_baud_rate = NULL; // HSU only
+    pn532->wake_up = pn532_spi_wake_up;
+    pn532->free = pn532_spi_free;
+
+    ESP_LOGI(TAG, "pn532 spi initialized");
+    return ESP_OK;
+}
@@ -0,0 +1,192 @@
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#ifdef CONFIG_PN532_STATS
+
+extern esp_err_t pn532_run(pn532_t* pn532, pn532_priority_t priority, pn532_job_t job, void* ctx);
+
+static size_t pn532_stats_bucket(uint32_t latency_us) {
+    // bucket 0 holds everything below PN532_STATS_HIST_BASE_US, each further bucket doubles
+    uint32_t scaled = latency_us / PN532_STATS_HIST_BASE_US;
+    if(!scaled) {
+        return 0;
+    }
+
+    size_t bucket = 32 - __builtin_clz(scaled);
+    return (bucket < PN532_STATS_HIST_BUCKETS) ? bucket : PN532_STATS_HIST_BUCKETS - 1;
+}
+
+// seqlock writer side, only called with the handle mutex held so there is a single writer
+static void pn532_stats_write_begin(pn532_t* pn532) {
+    __atomic_store_n(&pn532->stats.seq, pn532->stats.seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void pn532_stats_write_end(pn532_t* pn532) {
+    __atomic_store_n(&pn532->stats.seq, pn532->stats.seq + 1, __ATOMIC_RELEASE);
+}
+
+static pn532_command_stats_t* pn532_stats_slot(pn532_t* pn532, uint8_t command) {
+    stats_specifics_t* stats = &pn532->stats;
+
+    uint8_t slot = stats->slots[command];
+    if(slot) {
+        return &stats->commands[slot - 1];
+    }
+
+    // last slot is reserved for commands that did not get their own
+    if(stats->num_commands < PN532_STATS_MAX_COMMANDS - 1) {
+        stats->commands[stats->num_commands].command = command;
+        stats->slots[command] = ++stats->num_commands;
+        return &stats->commands[stats->num_commands - 1];
+    }
+
+    stats->commands[PN532_STATS_MAX_COMMANDS - 1].command = PN532_STATS_OTHER;
+    return &stats->commands[PN532_STATS_MAX_COMMANDS - 1];
+}
+
+static void pn532_stats_count_error(pn532_command_stats_t* entry, esp_err_t err) {
+    switch(err) {
+        case ESP_ERR_TIMEOUT:
+            entry->timeouts++;
+            break;
+        case ESP_ERR_INVALID_CRC:
+            entry->checksum_errors++;
+            break;
+        default:
+            entry->errors++;
+            break;
+    }
+}
+
+void pn532_stats_record_ack(pn532_t* pn532, uint8_t command, size_t bytes_out, uint32_t write_time_us, uint32_t ack_latency_us, esp_err_t err) {
+    pn532_stats_write_begin(pn532);
+
+    pn532_command_stats_t* entry = pn532_stats_slot(pn532, command);
+    pn532->stats.current = entry;
+    pn532->stats.ack_at = esp_timer_get_time();
+
+    entry->count++;
+    entry->bytes_out += bytes_out;
+    entry->write_time_us += write_time_us;
+
+    if(err == ESP_OK) {
+        entry->ack_latency_us += ack_latency_us;
+        entry->ack_hist[pn532_stats_bucket(ack_latency_us)]++;
+    } else if(err == ESP_ERR_INVALID_RESPONSE) {
+        entry->bad_acks++;
+    } else {
+        pn532_stats_count_error(entry, err);
+    }
+
+    pn532_stats_write_end(pn532);
+}
+
+void pn532_stats_record_response(pn532_t* pn532, size_t bytes_in, esp_err_t err) {
+    pn532_command_stats_t* entry = pn532->stats.current;
+    if(!entry) {
+        return;
+    }
+
+    pn532_stats_write_begin(pn532);
+
+    if(err == ESP_OK) {
+        uint32_t latency_us = (uint32_t) (esp_timer_get_time() - pn532->stats.ack_at);
+        entry->responses++;
+        entry->bytes_in += bytes_in;
+        entry->response_latency_us += latency_us;
+        entry->response_hist[pn532_stats_bucket(latency_us)]++;
+    } else {
+        pn532_stats_count_error(entry, err);
+    }
+
+    pn532_stats_write_end(pn532);
+}
+
+void pn532_stats_record_retry(pn532_t* pn532) {
+    pn532_command_stats_t* entry = pn532->stats.current;
+    if(!entry) {
+        return;
+    }
+
+    pn532_stats_write_begin(pn532);
+    entry->retries++;
+    pn532_stats_write_end(pn532);
+}
+
+esp_err_t pn532_get_stats(pn532_handle_t pn532_handle, pn532_stats_t* stats) {
+    if(!pn532_handle || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    // seqlock reader side, retries while a transaction is recording
+    uint32_t begin = 0;
+    uint32_t end = 0;
+    do {
+        begin = __atomic_load_n(&pn532->stats.seq, __ATOMIC_ACQUIRE);
+        if(begin & 1) {
+            continue;
+        }
+
+        stats->num_commands = pn532->stats.num_commands;
+        memcpy(stats->commands, pn532->stats.commands, sizeof(stats->commands));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        end = __atomic_load_n(&pn532->stats.seq, __ATOMIC_RELAXED);
+    } while((begin & 1) || begin != end);
+
+    // the shared slot only counts once something landed in it
+    if(stats->commands[PN532_STATS_MAX_COMMANDS - 1].count) {
+        stats->num_commands = PN532_STATS_MAX_COMMANDS;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t pn532_reset_stats_job(pn532_t* pn532, void* ctx) {
+    pn532_stats_write_begin(pn532);
+    memset(pn532->stats.slots, 0, sizeof(pn532->stats.slots));
+    memset(pn532->stats.commands, 0, sizeof(pn532->stats.commands));
+    pn532->stats.num_commands = 0;
+    pn532->stats.current = NULL;
+    pn532_stats_write_end(pn532);
+
+    return ESP_OK;
+}
+
+esp_err_t pn532_reset_stats(pn532_handle_t pn532_handle) {
+    if(!pn532_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    // reset is rare, so it simply waits for the transaction in flight
+    return pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_reset_stats_job, NULL);
+}
+
+#else
+
+static const char* TAG = "pn532";
+
+void pn532_stats_record_ack(pn532_t* pn532, uint8_t command, size_t bytes_out, uint32_t write_time_us, uint32_t ack_latency_us, esp_err_t err) {}
+void pn532_stats_record_response(pn532_t* pn532, size_t bytes_in, esp_err_t err) {}
+void pn532_stats_record_retry(pn532_t* pn532) {}
+
+esp_err_t pn532_get_stats(pn532_handle_t pn532_handle, pn532_stats_t* stats) {
+    ESP_LOGE(TAG, "statistics disabled (CONFIG_PN532_STATS)");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t pn532_reset_stats(pn532_handle_t pn532_handle) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
@@ -0,0 +1,234 @@
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define PN532_TARGET_ACK_TIMEOUT 30
+#define PN532_TARGET_STATUS_MI 0x40 // more information, the initiator chained the next part
+#define PN532_TARGET_STATUS_ERROR 0x3F
+#define PN532_TARGET_RELEASED 0x29 // released by the initiator
+#define PN532_TARGET_RF_OFF 0x31 // initiator switched its field off
+#define PN532_TARGET_MAX_GT 47
+#define PN532_TARGET_MAX_TK 30
+
+static const char* TAG = "pn532";
+
+// a host ACK makes the PN532 drop the command it is still working on
+static const uint8_t pn532_abort[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+
+extern esp_err_t pn532_run(pn532_t* pn532, pn532_priority_t priority, pn532_job_t job, void* ctx);
+extern esp_err_t pn532_transceive_data(pn532_t* pn532, const uint8_t* command, size_t command_len, const uint8_t* data, size_t data_len, uint32_t ack_timeout, uint32_t response_timeout, pn532_latency_t* latency);
+
+typedef struct {
+    const pn532_target_config_t* config;
+    pn532_target_stats_t* stats;
+    uint8_t chain[PN532_TARGET_MAX_COMMAND]; // chained initiator commands are joined here
+    uint8_t response[PN532_TARGET_MAX_RESPONSE];
+} pn532_target_job_t;
+
+static esp_err_t pn532_target_activate(pn532_t* pn532, pn532_target_job_t* job) {
+    const pn532_target_config_t* config = job->config;
+
+    // Mode MifareParams FeliCaParams NFCID3t LEN_Gt Gt LEN_Tk Tk
+    uint8_t data[1 + 6 + 18 + 10 + 1 + PN532_TARGET_MAX_GT + 1 + PN532_TARGET_MAX_TK];
+    size_t len = 0;
+    data[len++] = config->mode;
+    memcpy(&data[len], config->mifare_params, sizeof(config->mifare_params));
+    len += sizeof(config->mifare_params);
+    memcpy(&data[len], config->felica_params, sizeof(config->felica_params));
+    len += sizeof(config->felica_params);
+    memcpy(&data[len], config->nfcid3t, sizeof(config->nfcid3t));
+    len += sizeof(config->nfcid3t);
+    data[len++] = config->general_bytes_len;
+    if(config->general_bytes_len) {
+        memcpy(&data[len], config->general_bytes, config->general_bytes_len);
+        len += config->general_bytes_len;
+    }
+    data[len++] = config->historical_bytes_len;
+    if(config->historical_bytes_len) {
+        memcpy(&data[len], config->historical_bytes, config->historical_bytes_len);
+        len += config->historical_bytes_len;
+    }
+
+    uint8_t command[] = {PN532_COMMAND_TGINITASTARGET};
+    esp_err_t err = pn532_transceive_data(pn532, command, sizeof(command), data, len, PN532_TARGET_ACK_TIMEOUT, config->activation_timeout, NULL);
+    if(err == ESP_ERR_TIMEOUT) {
+        // no initiator showed up, the PN532 is still waiting for one
+        (void) pn532->write_raw(pn532, pn532_abort, sizeof(pn532_abort));
+        return err;
+    }
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    // D5 8D Mode InitiatorCommand
+    const uint8_t* response = pn532->response_data;
+    if(pn532->response_data_len < 3 || response[1] != PN532_COMMAND_TGINITASTARGET + 1) {
+        ESP_LOGE(TAG, "failed to check init as target response");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    job->stats->mode = response[2];
+    return ESP_OK;
+}
+
+// receives the next initiator command, joining chained parts, ESP_ERR_NOT_FOUND once the initiator is gone
+static esp_err_t pn532_target_get_data(pn532_t* pn532, pn532_target_job_t* job, const uint8_t** command, size_t* command_len) {
+    size_t chained = 0;
+    while(true) {
+        uint8_t get_data[] = {PN532_COMMAND_TGGETDATA};
+        esp_err_t err = pn532_transceive_data(pn532, get_data, sizeof(get_data), NULL, 0, PN532_TARGET_ACK_TIMEOUT, job->config->exchange_timeout, NULL);
+        if(err == ESP_ERR_TIMEOUT) {
+            // the initiator left without a release
+            (void) pn532->write_raw(pn532, pn532_abort, sizeof(pn532_abort));
+            return ESP_ERR_NOT_FOUND;
+        }
+        if(err != ESP_OK) {
+            return err;
+        }
+
+        // D5 87 Status DataIn
+        const uint8_t* response = pn532->response_data;
+        if(pn532->response_data_len < 3 || response[1] != PN532_COMMAND_TGGETDATA + 1) {
+            ESP_LOGE(TAG, "failed to check get data response");
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+
+        uint8_t status = response[2] & PN532_TARGET_STATUS_ERROR;
+        if(status == PN532_TARGET_RELEASED || status == PN532_TARGET_RF_OFF) {
+            return ESP_ERR_NOT_FOUND;
+        }
+        if(status) {
+            ESP_LOGE(TAG, "target error: %02X", status);
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        const uint8_t* data = &response[3];
+        size_t len = pn532->response_data_len - 3;
+
+        // the common unchained command is handed over straight from the handle buffer
+        if(!chained && !(response[2] & PN532_TARGET_STATUS_MI)) {
+            *command = data;
+            *command_len = len;
+            return ESP_OK;
+        }
+
+        if(chained + len > sizeof(job->chain)) {
+            ESP_LOGE(TAG, "chained command too long");
+            return ESP_ERR_INVALID_SIZE;
+        }
+        memcpy(&job->chain[chained], data, len);
+        chained += len;
+
+        if(!(response[2] & PN532_TARGET_STATUS_MI)) {
+            *command = job->chain;
+            *command_len = chained;
+            return ESP_OK;
+        }
+    }
+}
+
+static esp_err_t pn532_target_job(pn532_t* pn532, void* ctx) {
+    pn532_target_job_t* job = (pn532_target_job_t*) ctx;
+    const pn532_target_config_t* config = job->config;
+    pn532_target_stats_t* stats = job->stats;
+
+    esp_err_t err = pn532_target_activate(pn532, job);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    static const uint8_t set_data[] = {PN532_COMMAND_TGSETDATA};
+    while(true) {
+        const uint8_t* command = NULL;
+        size_t command_len = 0;
+        err = pn532_target_get_data(pn532, job, &command, &command_len);
+        if(err == ESP_ERR_NOT_FOUND) {
+            return ESP_OK;
+        }
+        if(err != ESP_OK) {
+            return err;
+        }
+        int64_t received_at = esp_timer_get_time();
+
+        size_t response_len = sizeof(job->response);
+        err = config->handler(command, command_len, job->response, &response_len, config->arg);
+        int64_t handled_at = esp_timer_get_time();
+        if(err != ESP_OK) {
+            ESP_LOGE(TAG, "target handler failed: %d", err);
+            return err;
+        }
+        if(response_len > sizeof(job->response)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        // the response goes out behind the constant TgSetData header without being copied
+        pn532_latency_t latency = {0};
+        err = pn532_transceive_data(pn532, set_data, sizeof(set_data), job->response, response_len, PN532_TARGET_ACK_TIMEOUT, config->exchange_timeout, &latency);
+        if(err != ESP_OK) {
+            return err;
+        }
+
+        // turnaround ends once the PN532 took the response, the rest is the RF exchange
+        uint32_t turnaround_us = (uint32_t) (handled_at - received_at) + latency.ack_latency_us;
+        stats->exchanges++;
+        stats->bytes_in += command_len;
+        stats->bytes_out += response_len;
+        stats->last_turnaround_us = turnaround_us;
+        stats->total_turnaround_us += turnaround_us;
+        stats->handler_us += handled_at - received_at;
+        if(turnaround_us > stats->max_turnaround_us) {
+            stats->max_turnaround_us = turnaround_us;
+        }
+
+        // D5 8F Status
+        const uint8_t* response = pn532->response_data;
+        if(pn532->response_data_len < 3 || response[1] != PN532_COMMAND_TGSETDATA + 1) {
+            ESP_LOGE(TAG, "failed to check set data response");
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+
+        uint8_t status = response[2] & PN532_TARGET_STATUS_ERROR;
+        if(status == PN532_TARGET_RELEASED || status == PN532_TARGET_RF_OFF) {
+            return ESP_OK;
+        }
+        if(status) {
+            ESP_LOGE(TAG, "target error: %02X", status);
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+}
+
+esp_err_t pn532_target_run(pn532_handle_t pn532_handle, const pn532_target_config_t* config, pn532_target_stats_t* stats) {
+    if(!pn532_handle || !config || !config->handler || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(config->general_bytes_len > PN532_TARGET_MAX_GT || (config->general_bytes_len && !config->general_bytes) ||
+       config->historical_bytes_len > PN532_TARGET_MAX_TK || (config->historical_bytes_len && !config->historical_bytes)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pn532_t* pn532 = (pn532_t*) pn532_handle;
+
+    // too large for most task stacks, allocated once per session rather than per exchange
+    pn532_target_job_t* job = (pn532_target_job_t*) malloc(sizeof(pn532_target_job_t));
+    if(!job) {
+        return ESP_ERR_NO_MEM;
+    }
+    job->config = config;
+    job->stats = stats;
+
+    memset(stats, 0, sizeof(pn532_target_stats_t));
+    esp_err_t err = pn532_run(pn532, PN532_PRIORITY_NORMAL, pn532_target_job, job);
+    free(job);
+    if(err != ESP_OK && err != ESP_ERR_TIMEOUT) {
+        ESP_LOGE(TAG, "target session failed");
+    }
+
+    return err;
+}
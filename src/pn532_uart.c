@@ -1,81 +1,254 @@
 #include "pn532.h"
 #include "pn532_types.h"
 
+#include <string.h>
+
+#include "freertos/task.h"
+
 #include "esp_log.h"
 
-#define PN532_UART_RX_BUF_SIZE 256
-#define PN532_UART_TX_BUF_SIZE 256
+#ifdef CONFIG_PN532_UART_RX_BUFFER_SIZE
+    #define PN532_UART_RX_BUF_SIZE CONFIG_PN532_UART_RX_BUFFER_SIZE
+    #define PN532_UART_TX_BUF_SIZE CONFIG_PN532_UART_TX_BUFFER_SIZE
+#else
+    #define PN532_UART_RX_BUF_SIZE 512 // fits an extended frame
+    #define PN532_UART_TX_BUF_SIZE 256
+#endif
+#define PN532_UART_WAKE_DELAY_MS 2
+#define PN532_UART_IDLE_TICKS (pdMS_TO_TICKS(2) + 1) // far longer than a byte at any baud rate
 
 #define UART_PORT(pn532) ((pn532)->uart.uart_port)
+// worst case time on the wire for a full frame (10 bits per byte) plus a couple of ticks of slack
+#define FRAME_TIMEOUT(pn532) (pdMS_TO_TICKS(((pn532)->buffer_size * 10 * 1000) / (pn532)->uart.baud_rate) + 2)
 
 static const char* TAG = "pn532";
 
-static esp_err_t pn532_uart_write_command(pn532_t* pn532, uint8_t* command, uint8_t command_len) {
-    (void) uart_flush(UART_PORT(pn532));
+extern esp_err_t pn532_irq_init(pn532_t* pn532, gpio_num_t irq);
+extern void pn532_irq_free(pn532_t* pn532);
+
+static esp_err_t pn532_uart_write_frame(pn532_t* pn532, const pn532_iovec_t* iov, size_t iov_count) {
+    #ifdef PN532_DEBUG
+        ESP_LOGD(TAG, "writing command:");
+    #endif
 
-    size_t data_len = command_len + 1;
-    uint8_t cmd[data_len + 6];
+    // the driver copies into its tx ring buffer, so the parts are never joined here
+    for(size_t i = 0; i < iov_count; i++) {
+        if(!iov[i].len) {
+            continue;
+        }
 
-    cmd[0] = PN532_PREAMBLE;
-    cmd[1] = PN532_STARTCODE1;
-    cmd[2] = PN532_STARTCODE2;
-    cmd[3] = data_len;
-    cmd[4] = ~data_len + 1;
-    cmd[5] = PN532_HOSTTOPN532;
+        #ifdef PN532_DEBUG
+            ESP_LOG_BUFFER_HEX_LEVEL(TAG, iov[i].data, iov[i].len, ESP_LOG_DEBUG);
+        #endif
 
-    for(size_t i = 0; i < command_len; i++) {
-        cmd[6 + i] = command[i];
+        int written = uart_write_bytes(UART_PORT(pn532), (const char*) iov[i].data, iov[i].len);
+        if(written != (int) iov[i].len) {
+            ESP_LOGE(TAG, "failed to write command");
+            return ESP_FAIL;
+        }
     }
 
-    uint8_t checksum = PN532_HOSTTOPN532;
-    for(size_t i = 0; i < command_len; i++) {
-        checksum += command[i];
-    }
-    checksum = ~checksum + 1;
-    
-    cmd[6 + command_len] = checksum;
-    cmd[7 + command_len] = PN532_POSTAMBLE;
+    return ESP_OK;
+}
 
+static esp_err_t pn532_uart_write_raw(pn532_t* pn532, const uint8_t* data, size_t len) {
     #ifdef PN532_DEBUG
-        ESP_LOGD(TAG, "writing command:");
-        ESP_LOG_BUFFER_HEX_LEVEL(TAG, cmd, sizeof(cmd), ESP_LOG_DEBUG);
+        ESP_LOGD(TAG, "writing raw:");
+        ESP_LOG_BUFFER_HEX_LEVEL(TAG, data, len, ESP_LOG_DEBUG);
     #endif
 
-    if(xSemaphoreTake(pn532->mutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
-        ESP_LOGE(TAG, "failed to take mutex");
+    int written = uart_write_bytes(UART_PORT(pn532), (const char*) data, len);
+    if(written != (int) len) {
+        ESP_LOGE(TAG, "failed to write data");
         return ESP_FAIL;
     }
 
-    int written = uart_write_bytes(UART_PORT(pn532), (const char*) cmd, sizeof(cmd));
-    if(written != sizeof(cmd)) {
-        ESP_LOGE(TAG, "failed to write command");
-        xSemaphoreGive(pn532->mutex);
-        return ESP_FAIL;
+    return ESP_OK;
+}
+
+static esp_err_t pn532_uart_read_exact(pn532_t* pn532, uint8_t* data, size_t len, TickType_t deadline) {
+    size_t received = 0;
+    while(received < len) {
+        TickType_t now = xTaskGetTickCount();
+        TickType_t remaining = ((int32_t) (deadline - now) > 0) ? (deadline - now) : 0;
+
+        int read = uart_read_bytes(UART_PORT(pn532), data + received, len - received, remaining);
+        if(read < 0) {
+            ESP_LOGE(TAG, "failed to read response");
+            return ESP_FAIL;
+        }
+        received += read;
+
+        if(received < len && !remaining) {
+            return ESP_ERR_TIMEOUT;
+        }
     }
 
-    xSemaphoreGive(pn532->mutex);
     return ESP_OK;
 }
 
-static esp_err_t pn532_uart_read_response(pn532_t* pn532, TickType_t timeout) {
-    if(xSemaphoreTake(pn532->mutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
-        ESP_LOGE(TAG, "failed to take mutex");
-        return ESP_FAIL;
+// drops the rest of a frame that can not be used, so the next read starts on a frame boundary
+static void pn532_uart_skip(pn532_t* pn532, size_t len, TickType_t deadline) {
+    uint8_t scratch[32];
+    while(len) {
+        size_t chunk = (len < sizeof(scratch)) ? len : sizeof(scratch);
+        if(pn532_uart_read_exact(pn532, scratch, chunk, deadline) != ESP_OK) {
+            return;
+        }
+        len -= chunk;
     }
+}
 
-    int len = uart_read_bytes(UART_PORT(pn532), pn532->buffer, PN532_BUFFER_SIZE, timeout);
-    if(len < 0) {
-        ESP_LOGE(TAG, "failed to read response");
-        xSemaphoreGive(pn532->mutex);
-        return ESP_FAIL;
+// drops bytes until the line goes quiet, for frames whose length can not be trusted
+static void pn532_uart_drain(pn532_t* pn532) {
+    uint8_t scratch[32];
+    while(uart_read_bytes(UART_PORT(pn532), scratch, sizeof(scratch), PN532_UART_IDLE_TICKS) > 0) {
+    }
+}
+
+static esp_err_t pn532_uart_read_frame(pn532_t* pn532, uint8_t* frame, size_t frame_size, size_t* frame_len, TickType_t timeout) {
+    // wait for start code (00 FF), garbage on the line does not extend the timeout
+    TickType_t deadline = xTaskGetTickCount() + timeout;
+    uint8_t previous = 0xFF;
+    uint8_t current = 0xFF;
+    while(!(previous == PN532_STARTCODE1 && current == PN532_STARTCODE2)) {
+        previous = current;
+        esp_err_t err = pn532_uart_read_exact(pn532, &current, 1, deadline);
+        if(err != ESP_OK) {
+            return err;
+        }
+    }
+
+    // once the frame started, the rest of it only needs its time on the wire
+    deadline = xTaskGetTickCount() + FRAME_TIMEOUT(pn532);
+
+    // the header is kept aside until the whole frame is known to fit in frame_size
+    uint8_t header[8] = {
+        PN532_PREAMBLE,
+        PN532_STARTCODE1,
+        PN532_STARTCODE2,
+    };
+    esp_err_t err = pn532_uart_read_exact(pn532, &header[3], 2, deadline);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    bool ack = false;
+    size_t len = 0;
+    size_t header_len = 5;
+    size_t total = 0;
+    if((header[3] == 0x00 && header[4] == 0xFF) || (header[3] == 0xFF && header[4] == 0x00)) {
+        // ack (00 FF) and nack (FF 00) frames carry no data, only the postamble
+        err = pn532_uart_read_exact(pn532, &header[5], 1, deadline);
+        if(err != ESP_OK) {
+            return err;
+        }
+        ack = true;
+        header_len = 6;
+        total = 6;
+    } else if(header[3] == 0xFF && header[4] == 0xFF) {
+        // extended frame: 00 00 FF FF FF LENm LENl LCS
+        err = pn532_uart_read_exact(pn532, &header[5], 3, deadline);
+        if(err != ESP_OK) {
+            return err;
+        }
+        if((uint8_t) (header[5] + header[6] + header[7]) != 0) {
+            ESP_LOGE(TAG, "invalid length checksum");
+            pn532_uart_drain(pn532);
+            return ESP_ERR_INVALID_CRC;
+        }
+        len = (header[5] << 8) | header[6];
+        header_len = 8;
+        total = header_len + len + 2; // header + data (LEN) + DCS + postamble
+    } else {
+        if((uint8_t) (header[3] + header[4]) != 0) {
+            ESP_LOGE(TAG, "invalid length checksum");
+            pn532_uart_drain(pn532);
+            return ESP_ERR_INVALID_CRC;
+        }
+        len = header[3];
+        total = header_len + len + 2;
+    }
+
+    if(total > frame_size) {
+        ESP_LOGE(TAG, "frame too long: %d", (int) total);
+        if(!ack) {
+            pn532_uart_skip(pn532, len + 2, deadline);
+        }
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(frame, header, header_len);
+
+    if(ack) {
+        *frame_len = 6;
+
+        #ifdef PN532_DEBUG
+            ESP_LOGD(TAG, "reading frame:");
+            ESP_LOG_BUFFER_HEX_LEVEL(TAG, frame, *frame_len, ESP_LOG_DEBUG);
+        #endif
+
+        return ESP_OK;
     }
 
+    err = pn532_uart_read_exact(pn532, &frame[header_len], len + 2, deadline);
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    uint8_t checksum = 0;
+    for(size_t i = 0; i < len + 1; i++) {
+        checksum += frame[header_len + i];
+    }
+    if(checksum != 0) {
+        ESP_LOGE(TAG, "invalid data checksum");
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    *frame_len = total;
+
     #ifdef PN532_DEBUG
-        ESP_LOGD(TAG, "reading response:");
-        ESP_LOG_BUFFER_HEX_LEVEL(TAG, pn532->buffer, PN532_UART_RX_BUF_SIZE, ESP_LOG_DEBUG);
+        ESP_LOGD(TAG, "reading frame:");
+        ESP_LOG_BUFFER_HEX_LEVEL(TAG, frame, *frame_len, ESP_LOG_DEBUG);
     #endif
 
-    xSemaphoreGive(pn532->mutex);
+    return ESP_OK;
+}
+
+static esp_err_t pn532_uart_wake_up(pn532_t* pn532) {
+    // HSU wake-up: PN532_WAKEUP then a long preamble, the PN532 needs it on the line before the next frame
+    static const uint8_t wake_up[] = {
+        PN532_WAKEUP, PN532_WAKEUP,
+        PN532_PREAMBLE, PN532_PREAMBLE, PN532_PREAMBLE, PN532_PREAMBLE, PN532_PREAMBLE, PN532_PREAMBLE, PN532_PREAMBLE,
+        PN532_PREAMBLE, PN532_PREAMBLE, PN532_PREAMBLE, PN532_PREAMBLE, PN532_PREAMBLE, PN532_PREAMBLE, PN532_PREAMBLE,
+    };
+    esp_err_t err = pn532_uart_write_raw(pn532, wake_up, sizeof(wake_up));
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    (void) uart_wait_tx_done(UART_PORT(pn532), FRAME_TIMEOUT(pn532));
+    vTaskDelay(pdMS_TO_TICKS(PN532_UART_WAKE_DELAY_MS) + 1);
+    (void) uart_flush_input(UART_PORT(pn532));
+
+    return ESP_OK;
+}
+
+static esp_err_t pn532_uart_set_baud_rate(pn532_t* pn532, uint32_t baud_rate) {
+    // anything still queued must leave at the old rate
+    esp_err_t err = uart_wait_tx_done(UART_PORT(pn532), FRAME_TIMEOUT(pn532));
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "uart_wait_tx_done failed: %d", err);
+        return err;
+    }
+
+    err = uart_set_baudrate(UART_PORT(pn532), baud_rate);
+    if(err != ESP_OK) {
+        ESP_LOGE(TAG, "uart_set_baudrate failed: %d", err);
+        return err;
+    }
+    (void) uart_flush_input(UART_PORT(pn532));
+
+    pn532->uart.baud_rate = baud_rate;
     return ESP_OK;
 }
 
@@ -86,14 +259,26 @@ static esp_err_t pn532_uart_free(pn532_t* pn532) {
         return err;
     }
 
-    vSemaphoreDelete(pn532->mutex);
+    pn532_irq_free(pn532);
 
     return ESP_OK;
 }
 
 esp_err_t pn532_uart_init(pn532_t* pn532, const pn532_uart_config_t* config) {
+    if(!config->baud_rate) {
+        ESP_LOGE(TAG, "invalid baud rate");
+        return ESP_ERR_INVALID_ARG;
+    }
+
     pn532->protocol = PN532_UART_PROTOCOL;
     UART_PORT(pn532) = config->uart_port;
+    pn532->uart.baud_rate = config->baud_rate;
+
+    // the driver only takes no tx buffer or one larger than the hardware fifo
+    if(PN532_UART_TX_BUF_SIZE != 0 && PN532_UART_TX_BUF_SIZE <= UART_HW_FIFO_LEN(UART_PORT(pn532))) {
+        ESP_LOGE(TAG, "tx buffer size must be 0 or above %d: %d", (int) UART_HW_FIFO_LEN(UART_PORT(pn532)), PN532_UART_TX_BUF_SIZE);
+        return ESP_ERR_INVALID_ARG;
+    }
 
     const uart_config_t uart_config = {
         .baud_rate = config->baud_rate,
@@ -106,38 +291,38 @@ esp_err_t pn532_uart_init(pn532_t* pn532, const pn532_uart_config_t* config) {
     esp_err_t err = uart_param_config(UART_PORT(pn532), &uart_config);
     if(err != ESP_OK) {
         ESP_LOGE(TAG, "uart_param_config failed: %d", err);
-        goto ERR;
+        return err;
     }
 
     err = uart_set_pin(UART_PORT(pn532), config->tx, config->rx, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
     if(err != ESP_OK) {
         ESP_LOGE(TAG, "uart_set_pin failed: %d", err);
-        goto ERR;
+        return err;
     }
 
     err = uart_driver_install(UART_PORT(pn532), PN532_UART_RX_BUF_SIZE, PN532_UART_TX_BUF_SIZE, 0, NULL, 0);
     if(err != ESP_OK) {
         ESP_LOGE(TAG, "uart_driver_install failed: %d", err);
-        goto ERR;
+        return err;
     }
     (void) uart_flush(UART_PORT(pn532));
 
-    pn532->mutex = xSemaphoreCreateMutex();
-    if(!pn532->mutex) {
-        ESP_LOGE(TAG, "failed to create mutex");
-        uart_driver_delete(UART_PORT(pn532));
-        free(pn532);
-        return ESP_ERR_NO_MEM;
+    pn532->irq.pin = GPIO_NUM_NC;
+    if(config->use_irq) {
+        err = pn532_irq_init(pn532, config->irq);
+        if(err != ESP_OK) {
+            uart_driver_delete(UART_PORT(pn532));
+            return err;
+        }
     }
 
-    pn532->write_command = pn532_uart_write_command;
-    pn532->read_response = pn532_uart_read_response;
+    pn532->write_frame = pn532_uart_write_frame;
+    pn532->write_raw = pn532_uart_write_raw;
+    pn532->read_frame = pn532_uart_read_frame;
+    pn532->set_baud_rate = pn532_uart_set_baud_rate;
+    pn532->wake_up = pn532_uart_wake_up;
     pn532->free = pn532_uart_free;
 
     ESP_LOGI(TAG, "pn532 uart initialized");
     return ESP_OK;
-
-ERR:
-    free(pn532);
-    return err;
 }
\ No newline at end of file
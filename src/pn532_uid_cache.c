@@ -0,0 +1,113 @@
+#include "pn532.h"
+#include "pn532_types.h"
+
+#include <string.h>
+
+#if PN532_UID_CACHE_SIZE > 0
+
+#define ENTRIES(pn532) ((pn532)->autopoll.cache.entries)
+
+// FNV-1a over the UID bytes
+static size_t pn532_uid_cache_home(const uint8_t* uid, uint8_t uid_len) {
+    uint32_t hash = 2166136261u;
+    for(size_t i = 0; i < uid_len; i++) {
+        hash = (hash ^ uid[i]) * 16777619u;
+    }
+    return hash % PN532_UID_CACHE_SIZE;
+}
+
+void pn532_uid_cache_clear(pn532_t* pn532) {
+    memset(&pn532->autopoll.cache, 0, sizeof(pn532->autopoll.cache));
+}
+
+// refreshes a UID, returns true if it was not cached (an arrival)
+bool pn532_uid_cache_seen(pn532_t* pn532, uint8_t type, const pn532_target_t* target, int64_t now) {
+    size_t slot = pn532_uid_cache_home(target->uid, target->uid_len);
+    for(size_t probe = 0; probe < PN532_UID_CACHE_SIZE; probe++) {
+        uid_cache_entry_t* entry = &ENTRIES(pn532)[slot];
+
+        if(!entry->uid_len) {
+            memcpy(entry->uid, target->uid, target->uid_len);
+            entry->uid_len = target->uid_len;
+            entry->type = type;
+            entry->sak = target->sak;
+            entry->last_seen_us = now;
+            pn532->autopoll.cache.count++;
+            return true;
+        }
+
+        if(entry->uid_len == target->uid_len && !memcmp(entry->uid, target->uid, target->uid_len)) {
+            entry->last_seen_us = now;
+            return false;
+        }
+
+        slot = (slot + 1) % PN532_UID_CACHE_SIZE;
+    }
+
+    // full, the target is reported every time until a slot frees up
+    return true;
+}
+
+// backward shift deletion, keeps every probe sequence intact without tombstones
+static void pn532_uid_cache_remove(pn532_t* pn532, size_t slot) {
+    size_t next = slot;
+    for(size_t probe = 1; probe < PN532_UID_CACHE_SIZE; probe++) {
+        next = (next + 1) % PN532_UID_CACHE_SIZE;
+        uid_cache_entry_t* entry = &ENTRIES(pn532)[next];
+        if(!entry->uid_len) {
+            break;
+        }
+
+        // the entry can fill the hole unless its home lies cyclically in (slot, next]
+        size_t home = pn532_uid_cache_home(entry->uid, entry->uid_len);
+        bool stays = (slot <= next) ? (home > slot && home <= next) : (home > slot || home <= next);
+        if(!stays) {
+            ENTRIES(pn532)[slot] = *entry;
+            slot = next;
+        }
+    }
+
+    ENTRIES(pn532)[slot].uid_len = 0;
+    pn532->autopoll.cache.count--;
+}
+
+// removes the next UID last seen before seen_before, starting at *cursor, returns false once the sweep is done
+bool pn532_uid_cache_next_departed(pn532_t* pn532, size_t* cursor, int64_t seen_before, pn532_scan_event_t* event) {
+    if(!pn532->autopoll.cache.count) {
+        return false;
+    }
+
+    for(; *cursor < PN532_UID_CACHE_SIZE; (*cursor)++) {
+        uid_cache_entry_t* entry = &ENTRIES(pn532)[*cursor];
+        if(!entry->uid_len || entry->last_seen_us >= seen_before) {
+            continue;
+        }
+
+        memset(event, 0, sizeof(pn532_scan_event_t));
+        event->kind = PN532_SCAN_DEPARTED;
+        event->type = entry->type;
+        event->target.sak = entry->sak;
+        event->target.uid_len = entry->uid_len;
+        memcpy(event->target.uid, entry->uid, entry->uid_len);
+
+        // the slot is checked again on the next call, removal may have shifted another entry into it
+        pn532_uid_cache_remove(pn532, *cursor);
+        return true;
+    }
+
+    return false;
+}
+
+#else
+
+void pn532_uid_cache_clear(pn532_t* pn532) {}
+
+bool pn532_uid_cache_seen(pn532_t* pn532, uint8_t type, const pn532_target_t* target, int64_t now) {
+    return true;
+}
+
+bool pn532_uid_cache_next_departed(pn532_t* pn532, size_t* cursor, int64_t seen_before, pn532_scan_event_t* event) {
+    return false;
+}
+
+#endif